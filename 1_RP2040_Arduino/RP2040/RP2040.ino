@@ -1,7 +1,10 @@
 #include <Arduino.h>
 #include <ArduinoJson.h>
 #include "picobase64.h"
+#include "frame_proto.h"
 #include <PacketSerial.h>
+#include <pico/mutex.h>
+#include <atomic>
 #include <stdbool.h>
 // SSCMA library for AI inference
 #include "Seeed_Arduino_SSCMA.h"
@@ -10,29 +13,70 @@
 // Configuration constants
 #define _LOG 0  // Disable it if needed for high frequency
 #define pcSerial Serial
-#define ESP32_COMM_BAUD_RATE 921600
+#define ESP32_COMM_BAUD_RATE 921600       // Power-on and fallback rate, fixed on both sides
+#define ESP32_COMM_MAX_BAUD_RATE 4000000
+#define LINK_SWITCH_GUARD_MS 20           // Lets the ESP32 handle the reply before the rate changes
+#define LINK_CONFIRM_TIMEOUT_MS 1500      // Longer than the ESP32's probe timeout
+#define LINK_KEEPALIVE_TIMEOUT_MS 3000    // The ESP32 repeats CMD_BAUD_CONFIRM every second while the rate is up
 #define JSON_BUFFER_SIZE 2048
 #define IMAGE_BUFFER_SIZE 4096
 #define MUTEX_TIMEOUT_MS 1000
 #define BEEP_DURATION_MS 50
+#define BEEP_MAX_MS 2000
+#define FRAME_META_BUFFER_SIZE 4096
+#define TX_SLOT_COUNT 2
+#define TX_SLOT_SIZE (40 * 1024)  // A binary frame, or the image line plus the result line in JSON mode
+#define IMAGE_JPEG_MAX_SIZE(w, h) ((size_t)(w) * (h) / 4 + 1024)  // Same bound as the ESP32's app_image.h
+#define TX_CHUNK_SIZE 256         // Bytes written per loop1() pass
+#define CTRL_SLOT_COUNT 4
+#define CTRL_PAYLOAD_SIZE 96      // Reply data, a model name at most
+#define CTRL_PACKET_SIZE 128      // 0x00, COBS of PKT_TYPE_ACK, id, status and data, 0x00
+#define REQUEST_COUNT 8
+#define INVOKE_STREAM 1           // AT+INVOKE=-1: the module runs at its own rate, 0 for one AT+INVOKE=1 per frame
+#define INVOKE_STALL_MS 3000      // Restart the stream after this long without an event
+
+// Link to the Grove Vision AI module
+#define AI_TRANSPORT_UART 0
+#define AI_TRANSPORT_I2C 1
+#define AI_TRANSPORT_SPI 2
+#define AI_TRANSPORT AI_TRANSPORT_UART
+#define AI_TRANSPORT_BENCH 0  // Print the throughput of AI_TRANSPORT at boot, needs _LOG
+#define AI_BENCH_FRAMES 100
+#define AI_BENCH_TIMEOUT_MS 60000
 
 // GPIO Pin definitions
 #define ESP_RX_PIN 17
 #define ESP_TX_PIN 16
-#define AT_TX_PIN 20  // (The port on the right side) Write line
-#define AT_RX_PIN 21  // Yellow line
+#define ESP_RTS_PIN -1  // Not routed on the Indicator; set both to enable RTS/CTS
+#define ESP_CTS_PIN -1
+#define AT_TX_PIN 20  // (The port on the right side) Write line, SDA in I2C mode
+#define AT_RX_PIN 21  // Yellow line, SCL in I2C mode
+#define AI_SPI_SCK_PIN -1  // SPI is not on the Grove port; set these to your wiring
+#define AI_SPI_MOSI_PIN -1
+#define AI_SPI_MISO_PIN -1
+#define AI_SPI_CS_PIN -1
+#define AI_SPI_SYNC_PIN -1  // Data-ready from the module: idle polls read the pin instead of sending AVAILABLE
 #define BUZZER_PIN 19
 
 // Serial interface definitions
 #define espSerial Serial1
 #define atSerial Serial2
 
-// Command packet types
+// Command packet types. Every packet from the ESP32 is type, id, payload; an id
+// other than 0 is answered with PKT_TYPE_ACK, id, status (CMD_*), reply data
 enum PacketType {
-  PKT_TYPE_CMD_BEEP_ON = 0xA1,
+  PKT_TYPE_CMD_BEEP_ON = 0xA1,      // uint32_t ms
   PKT_TYPE_CMD_SHUTDOWN = 0xA3,
   PKT_TYPE_CMD_POWER_ON = 0xA4,
-  PKT_TYPE_CMD_MODEL_TITLE = 0xA5
+  PKT_TYPE_CMD_MODEL_TITLE = 0xA5,  // reply: model name
+  PKT_TYPE_CMD_FRAME_MODE = 0xA6,   // uint8_t mode, uint8_t version; reply: uint8_t mode
+  PKT_TYPE_CMD_BAUD = 0xA7,         // uint32_t baud: reply uint32_t baud at the old rate, then switch
+  PKT_TYPE_CMD_BAUD_CONFIRM = 0xA8, // uint32_t baud: the ESP32 receives us fine at N
+  PKT_TYPE_CMD_MODEL = 0xA9,        // uint8_t model id
+  PKT_TYPE_CMD_TSCORE = 0xAA,       // uint8_t score threshold
+  PKT_TYPE_CMD_TIOU = 0xAB,         // uint8_t IoU threshold
+  PKT_TYPE_CMD_SENSOR = 0xAC,       // uint8_t opt_id; reply: uint16_t width, uint16_t height
+  PKT_TYPE_ACK = 0xC0
 };
 
 // Global objects
@@ -41,18 +85,94 @@ PacketSerial myPacketSerial;
 
 // JSON documents with fixed sizes for better memory management
 JsonDocument doc_info;
-JsonDocument doc_image;
 
 // Global state variables
-static bool shutdown_flag = false;
+static volatile bool shutdown_flag = false;
 static unsigned long last_beep_time = 0;
+static unsigned long beep_off_time = 0;
+static bool beep_active = false;  // Core 1 only
+
+static uint8_t frame_mode = FRAME_MODE_JSON;
+static uint16_t frame_seq = 0;
+static unsigned long last_invoke_time = 0;
+static uint8_t sensor_opt = 0;  // Last AT+SENSOR option that fits, the module boots at 240x240
+
+static volatile uint32_t confirmed_baud = 0;
+static volatile unsigned long confirm_time = 0;  // Last CMD_BAUD_CONFIRM, written before confirmed_baud
+static uint32_t link_baud = ESP32_COMM_BAUD_RATE;
+static unsigned long link_switch_time = 0;
+
+// Commands that need core 0, which owns AI and the link rate: received on core 1,
+// applied on core 0 between frames. Single-producer/single-consumer like the tx ring.
+struct Request {
+  uint8_t type;
+  uint8_t id;
+  uint32_t arg;
+};
+
+static Request requests[REQUEST_COUNT];
+static std::atomic<uint32_t> request_head{0};
+static std::atomic<uint32_t> request_tail{0};
+
+// Encoded replies, queued by either core and written by core 1 between tx chunks.
+// Producers take ctrl_mutex, core 1 only moves ctrl_tail.
+struct CtrlSlot {
+  size_t len;
+  uint8_t data[CTRL_PACKET_SIZE];
+};
+
+static CtrlSlot ctrl_slots[CTRL_SLOT_COUNT];
+static std::atomic<uint32_t> ctrl_head{0};
+static std::atomic<uint32_t> ctrl_tail{0};
+auto_init_mutex(ctrl_mutex);
+
+// Binary frame metadata, assembled before it is copied behind the JPEG
+static uint8_t frame_meta_buf[FRAME_META_BUFFER_SIZE];
+
+// Encoded frames, written by core 0 after each invoke and sent by core 1 while
+// core 0 runs the next one. Single-producer/single-consumer ring: core 0 only
+// moves tx_head, core 1 only moves tx_tail, and a slot is free again once core 1
+// has written all of it to the UART.
+struct TxSlot {
+  size_t len;
+  bool text;  // Lines only, so a control packet may go out in the middle
+  uint8_t data[TX_SLOT_SIZE];
+};
+
+static TxSlot tx_slots[TX_SLOT_COUNT];
+static std::atomic<uint32_t> tx_head{0};
+static std::atomic<uint32_t> tx_tail{0};
+static size_t tx_offset = 0;  // Bytes of the oldest slot already written, core 1 only
 
 // Function declarations
 static inline void AI_func(SSCMA& instance);
-static inline void send_model_title(SSCMA& instance);
+static void send_frame(SSCMA& instance);
+static size_t encode_json_frame(SSCMA& instance, uint8_t* out, size_t size);
+static size_t encode_binary_frame(SSCMA& instance, uint8_t* out, size_t size);
+static size_t encode_passthrough_frame(SSCMA& instance, uint8_t* out, size_t size);
+static TxSlot* tx_acquire(void);
+static void tx_publish(void);
+static void tx_drain(void);
+static bool tx_service(void);
+static bool ctrl_reply(uint8_t id, uint8_t status, const void* data = NULL, size_t len = 0);
+static bool ctrl_service(void);
+static void request_push(uint8_t type, uint8_t id, uint32_t arg);
+static void apply_requests(void);
+static void apply_frame_mode(uint8_t mode, uint8_t id);
+static void apply_sensor(uint8_t opt, uint8_t id);
+static bool image_fits(uint16_t width, uint16_t height);
+static void apply_link_baud(uint32_t baud, uint8_t id);
+static void check_link_baud(void);
+static void set_link_baud(uint32_t baud);
+static inline void send_model_title(SSCMA& instance, uint8_t id);
+static bool ai_begin(void);
+#if AI_TRANSPORT_BENCH
+static void transport_bench(void);
+#endif
 static void beep_init(void);
-static void beep_on(void);
+static void beep_on(uint32_t ms);
 static void beep_off(void);
+static void beep_poll(void);
 static bool safe_serial_print(const char* message);
 static bool safe_serial_print(const String& message);
 
@@ -61,26 +181,75 @@ const char compile_date[] = __DATE__ " " __TIME__;
 
 /************************ Communication handlers ****************************/
 void onPacketReceived(const uint8_t* buffer, size_t size) {
-  if (size < 1) {
+  if (size < 2) {
     return;
   }
+  uint8_t id = buffer[1];
+  const uint8_t* payload = buffer + 2;
+  size_t payload_len = size - 2;
+  uint32_t value = 0;
+  memcpy(&value, payload, min(payload_len, sizeof(value)));
 
   switch (static_cast<PacketType>(buffer[0])) {
     case PKT_TYPE_CMD_SHUTDOWN:
       safe_serial_print("cmd shutdown");
       shutdown_flag = true;
+      ctrl_reply(id, CMD_OK);
+      break;
+
+    case PKT_TYPE_CMD_POWER_ON:
+      shutdown_flag = false;
+      ctrl_reply(id, CMD_OK);
       break;
       
     case PKT_TYPE_CMD_BEEP_ON:
-      beep_on();
+      beep_on(payload_len >= sizeof(uint32_t) ? value : BEEP_DURATION_MS);
+      ctrl_reply(id, CMD_OK);
       break;
       
     case PKT_TYPE_CMD_MODEL_TITLE:
-      send_model_title(AI);
+      // AI belongs to core 0, which is busy in invoke()
+      request_push(PKT_TYPE_CMD_MODEL_TITLE, id, 0);
+      break;
+
+    case PKT_TYPE_CMD_MODEL:
+    case PKT_TYPE_CMD_TSCORE:
+    case PKT_TYPE_CMD_TIOU:
+    case PKT_TYPE_CMD_SENSOR:
+      if (payload_len >= 1) {
+        request_push(buffer[0], id, payload[0]);
+      } else {
+        ctrl_reply(id, CMD_EINVAL);
+      }
+      break;
+
+    case PKT_TYPE_CMD_FRAME_MODE:
+      // Only accept a protocol version we can produce
+      if (payload_len >= 2 && payload[1] == FRAME_PROTO_VERSION && payload[0] <= FRAME_MODE_PASSTHROUGH) {
+        request_push(PKT_TYPE_CMD_FRAME_MODE, id, payload[0]);
+      } else {
+        ctrl_reply(id, CMD_ENOTSUP);
+      }
+      break;
+
+    case PKT_TYPE_CMD_BAUD:
+      if (payload_len >= sizeof(uint32_t) && value >= ESP32_COMM_BAUD_RATE && value <= ESP32_COMM_MAX_BAUD_RATE) {
+        request_push(PKT_TYPE_CMD_BAUD, id, value);
+      } else {
+        ctrl_reply(id, CMD_EINVAL);
+      }
+      break;
+
+    case PKT_TYPE_CMD_BAUD_CONFIRM:
+      if (payload_len >= sizeof(uint32_t)) {
+        confirm_time = millis();
+        confirmed_baud = value;
+      }
+      ctrl_reply(id, CMD_OK);
       break;
       
     default:
-      // Unknown command - could log this for debugging
+      ctrl_reply(id, CMD_ENOTSUP);
       break;
   }
 }
@@ -92,19 +261,24 @@ void beep_init(void) {
 }
 
 void beep_off(void) {
-  digitalWrite(BUZZER_PIN, LOW);
+  analogWrite(BUZZER_PIN, 0);
+  beep_active = false;
 }
 
-void beep_on(void) {
-  // Non-blocking beep implementation
+// Core 1; beep_poll() turns it off, so loop1() keeps serving the link meanwhile
+void beep_on(uint32_t ms) {
   unsigned long current_time = millis();
   if (current_time - last_beep_time >= 100) { // Minimum 100ms between beeps
     analogWrite(BUZZER_PIN, 127);
     last_beep_time = current_time;
-    // Note: We should use a timer or state machine for proper non-blocking operation
-    // For now, keeping the delay but acknowledging it's not ideal
-    delay(BEEP_DURATION_MS);
-    analogWrite(BUZZER_PIN, 0);
+    beep_off_time = current_time + min(ms, (uint32_t)BEEP_MAX_MS);
+    beep_active = true;
+  }
+}
+
+void beep_poll(void) {
+  if (beep_active && (long)(millis() - beep_off_time) >= 0) {
+    beep_off();
   }
 }
 
@@ -144,10 +318,6 @@ void setup() {
   pcSerial.println(compile_date);
 #endif
 
-  atSerial.setRX(AT_RX_PIN);
-  atSerial.setTX(AT_TX_PIN);
-  atSerial.setFIFOSize(32 * 1024);
-  
   // Initialize AI with retry mechanism
   bool ai_initialized = false;
   int retry_count = 0;
@@ -156,7 +326,7 @@ void setup() {
   while (!ai_initialized && retry_count < max_retries) {
     safe_serial_print("AI init attempt " + String(retry_count + 1) + "/" + String(max_retries));
     
-    if (AI.begin(&atSerial)) {
+    if (ai_begin()) {
       ai_initialized = true;
       safe_serial_print("AI initialized successfully");
       
@@ -182,16 +352,70 @@ void setup() {
   if (!ai_initialized) {
     safe_serial_print("CRITICAL: Failed to initialize AI after all retries");
   }
+#if AI_TRANSPORT_BENCH
+  else {
+    transport_bench();
+  }
+#endif
+}
+
+static bool ai_begin(void) {
+#if AI_TRANSPORT == AI_TRANSPORT_I2C
+  Wire.setSDA(AT_TX_PIN);
+  Wire.setSCL(AT_RX_PIN);
+  return AI.begin(&Wire);
+#elif AI_TRANSPORT == AI_TRANSPORT_SPI
+#if AI_SPI_SCK_PIN < 0 || AI_SPI_MOSI_PIN < 0 || AI_SPI_MISO_PIN < 0
+#error "AI_TRANSPORT_SPI needs AI_SPI_*_PIN"
+#endif
+  SPI.setSCK(AI_SPI_SCK_PIN);
+  SPI.setTX(AI_SPI_MOSI_PIN);
+  SPI.setRX(AI_SPI_MISO_PIN);
+  return AI.begin(&SPI, AI_SPI_CS_PIN, AI_SPI_SYNC_PIN);
+#else
+  atSerial.setRX(AT_RX_PIN);
+  atSerial.setTX(AT_TX_PIN);
+  atSerial.setFIFOSize(32 * 1024);
+  return AI.begin(&atSerial);
+#endif
+}
+
+#if AI_TRANSPORT_BENCH
+// Streams AI_BENCH_FRAMES invokes and prints what the transport carried; flash
+// once per AI_TRANSPORT to compare UART, I2C and SPI on the same model
+static void transport_bench(void) {
+  static const char* names[] = {"UART", "I2C", "SPI"};
+  int frames = 0;
+  uint32_t bytes = AI.rx_total();
+  unsigned long start = millis();
+
+  if (AI.invoke_start(true, false) != CMD_OK) {
+    safe_serial_print("bench: invoke failed");
+    return;
+  }
+  while (frames < AI_BENCH_FRAMES && millis() - start < AI_BENCH_TIMEOUT_MS) {
+    frames += AI.fetch_invoke(nullptr);
+  }
+  AI.invoke_stop();
+
+  unsigned long ms = max(millis() - start, 1UL);
+  bytes = AI.rx_total() - bytes;
+  safe_serial_print(String("bench ") + names[AI_TRANSPORT] + ": " + frames + " frames, " + bytes + " bytes in " +
+                    ms + " ms, " + (bytes / ms) + " kB/s, " + String(frames * 1000.0f / ms, 1) + " fps");
 }
+#endif
 
 void loop() {
-  AI_func(AI);
   // Check shutdown flag
   if (shutdown_flag) {
-    safe_serial_print("Shutdown requested, entering low power mode");
+    if (AI.streaming()) {
+      safe_serial_print("Shutdown requested, entering low power mode");
+      AI.invoke_stop();
+    }
     // Implement shutdown logic here
     return;
   }
+  AI_func(AI);
 }
 
 /************************ ESP32 Communication ****************************/
@@ -200,6 +424,10 @@ void setup1() {
   // Configure ESP32 communication
   espSerial.setRX(ESP_RX_PIN);
   espSerial.setTX(ESP_TX_PIN);
+#if ESP_RTS_PIN >= 0 && ESP_CTS_PIN >= 0
+  espSerial.setRTS(ESP_RTS_PIN);
+  espSerial.setCTS(ESP_CTS_PIN);
+#endif
   espSerial.begin(ESP32_COMM_BAUD_RATE);
 
   // Initialize packet communication
@@ -209,110 +437,573 @@ void setup1() {
 }
 
 void loop1() {
+  tx_service();
   myPacketSerial.update();
+  beep_poll();
   
   if (myPacketSerial.overflow()) {
     safe_serial_print("PacketSerial buffer overflow detected");
   }
 }
 
+/************************ Core 0 -> core 1 frame queue ****************************/
+// Core 0: waits until core 1 has finished with the oldest slot
+static TxSlot* tx_acquire(void) {
+  uint32_t head = tx_head.load(std::memory_order_relaxed);
+  while (head - tx_tail.load(std::memory_order_acquire) >= TX_SLOT_COUNT) {
+    tight_loop_contents();
+  }
+  return &tx_slots[head % TX_SLOT_COUNT];
+}
+
+// Core 0: hands the slot from tx_acquire() to core 1
+static void tx_publish(void) {
+  tx_head.store(tx_head.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+}
+
+// Core 0: waits until every queued frame and reply is on the wire, e.g. before changing the rate
+static void tx_drain(void) {
+  while (tx_tail.load(std::memory_order_acquire) != tx_head.load(std::memory_order_relaxed) ||
+         ctrl_tail.load(std::memory_order_acquire) != ctrl_head.load(std::memory_order_acquire)) {
+    tight_loop_contents();
+  }
+  espSerial.flush();
+}
+
+// Core 1: writes a queued reply, or the next chunk of the oldest slot; returns false when there is nothing to send
+static bool tx_service(void) {
+  uint32_t tail = tx_tail.load(std::memory_order_relaxed);
+  bool busy = tail != tx_head.load(std::memory_order_acquire);
+
+  // The ESP32 takes a 0x00 in the middle of a line as a control packet, but a
+  // binary frame may contain 0x00 itself, so replies wait for its end
+  if ((!busy || tx_offset == 0 || tx_slots[tail % TX_SLOT_COUNT].text) && ctrl_service()) {
+    return true;
+  }
+  if (!busy) {
+    return false;
+  }
+
+  TxSlot& slot = tx_slots[tail % TX_SLOT_COUNT];
+  size_t n = min(slot.len - tx_offset, (size_t)TX_CHUNK_SIZE);
+  tx_offset += espSerial.write(slot.data + tx_offset, n);
+  if (tx_offset >= slot.len) {
+    tx_offset = 0;
+    tx_tail.store(tail + 1, std::memory_order_release);
+  }
+  return true;
+}
+
+/************************ Control replies ****************************/
+// Either core; an id of 0 asks for no reply. Dropped when the ring is full,
+// the ESP32 then times out on it.
+static bool ctrl_reply(uint8_t id, uint8_t status, const void* data, size_t len) {
+  if (id == 0) {
+    return true;
+  }
+
+  uint8_t raw[3 + CTRL_PAYLOAD_SIZE];
+  len = min(len, (size_t)CTRL_PAYLOAD_SIZE);
+  raw[0] = PKT_TYPE_ACK;
+  raw[1] = id;
+  raw[2] = status;
+  if (len > 0) {
+    memcpy(raw + 3, data, len);
+  }
+
+  bool queued = false;
+  mutex_enter_blocking(&ctrl_mutex);
+  uint32_t head = ctrl_head.load(std::memory_order_relaxed);
+  if (head - ctrl_tail.load(std::memory_order_acquire) < CTRL_SLOT_COUNT) {
+    // Delimited on both sides, so it can follow a partial line
+    CtrlSlot& slot = ctrl_slots[head % CTRL_SLOT_COUNT];
+    slot.data[0] = 0x00;
+    slot.len = 1 + COBS::encode(raw, 3 + len, slot.data + 1);
+    slot.data[slot.len++] = 0x00;
+    ctrl_head.store(head + 1, std::memory_order_release);
+    queued = true;
+  }
+  mutex_exit(&ctrl_mutex);
+
+  if (!queued) {
+    safe_serial_print("reply dropped, id " + String(id));
+  }
+  return queued;
+}
+
+// Core 1: writes the oldest queued reply
+static bool ctrl_service(void) {
+  uint32_t tail = ctrl_tail.load(std::memory_order_relaxed);
+  if (tail == ctrl_head.load(std::memory_order_acquire)) {
+    return false;
+  }
+  CtrlSlot& slot = ctrl_slots[tail % CTRL_SLOT_COUNT];
+  espSerial.write(slot.data, slot.len);
+  ctrl_tail.store(tail + 1, std::memory_order_release);
+  return true;
+}
+
+/************************ Core 1 -> core 0 requests ****************************/
+// Core 1
+static void request_push(uint8_t type, uint8_t id, uint32_t arg) {
+  uint32_t head = request_head.load(std::memory_order_relaxed);
+  if (head - request_tail.load(std::memory_order_acquire) >= REQUEST_COUNT) {
+    ctrl_reply(id, CMD_EBUSY);
+    return;
+  }
+  requests[head % REQUEST_COUNT] = {type, id, arg};
+  request_head.store(head + 1, std::memory_order_release);
+}
+
+// Core 0, between frames
+static void apply_requests(void) {
+  uint32_t tail = request_tail.load(std::memory_order_relaxed);
+  while (tail != request_head.load(std::memory_order_acquire)) {
+    Request req = requests[tail % REQUEST_COUNT];
+    request_tail.store(++tail, std::memory_order_release);
+
+    switch (req.type) {
+      case PKT_TYPE_CMD_FRAME_MODE:
+        apply_frame_mode(req.arg, req.id);
+        break;
+
+      case PKT_TYPE_CMD_BAUD:
+        apply_link_baud(req.arg, req.id);
+        break;
+
+      case PKT_TYPE_CMD_MODEL_TITLE:
+        // The ESP32 asks after a model change: break the stream so the new model is
+        // picked up, AI_func() starts it again
+        if (AI.streaming()) {
+          AI.invoke_stop();
+        }
+        send_model_title(AI, req.id);
+        break;
+
+      case PKT_TYPE_CMD_MODEL:
+      case PKT_TYPE_CMD_TSCORE:
+      case PKT_TYPE_CMD_TIOU: {
+        // The module only takes AT commands between invokes
+        if (AI.streaming()) {
+          AI.invoke_stop();
+        }
+        int ret = req.type == PKT_TYPE_CMD_MODEL    ? AI.set_model(req.arg)
+                  : req.type == PKT_TYPE_CMD_TSCORE ? AI.set_tscore(req.arg)
+                                                    : AI.set_tiou(req.arg);
+        ctrl_reply(req.id, ret);
+        break;
+      }
+
+      case PKT_TYPE_CMD_SENSOR:
+        if (AI.streaming()) {
+          AI.invoke_stop();
+        }
+        apply_sensor(req.arg, req.id);
+        break;
+    }
+  }
+}
+
 /************************ AI Processing ****************************/
 static inline void AI_func(SSCMA& instance) {
-  // Process AI inference
-  int invoke_result = instance.invoke(1, true, false);
-  if (invoke_result == 0) {  // CMD_OK = 0
-    doc_info.clear();
-    
-    // Process boxes
-    auto& boxes = instance.boxes();
-    JsonArray boxes_array = doc_info["boxes"].to<JsonArray>();
-    for (const auto& box : boxes) {
-      JsonArray box_array = boxes_array.add<JsonArray>();
-      box_array.add(box.x);
-      box_array.add(box.y);
-      box_array.add(box.w);
-      box_array.add(box.h);
-      box_array.add(box.score);
-      box_array.add(box.target);
+  apply_requests();
+  check_link_baud();
+
+#if INVOKE_STREAM
+  // The module keeps inferring while we encode; core 1 is still sending the previous frame meanwhile
+  if (!instance.streaming()) {
+    if (instance.invoke_start(true, false) != CMD_OK) {
+      return;
     }
+    last_invoke_time = millis();
+  }
+  if (instance.fetch_invoke([&instance]() { send_frame(instance); }) > 0) {
+    last_invoke_time = millis();
+  } else if (millis() - last_invoke_time > INVOKE_STALL_MS) {
+    safe_serial_print("invoke stream stalled, restarting");
+    instance.invoke_stop();
+  }
+#else
+  // Process AI inference; core 1 is still sending the previous frame meanwhile
+  if (instance.invoke(1, true, false) == CMD_OK) {
+    send_frame(instance);
+  }
+#endif
+}
 
-    // Process classes
-    auto& classes = instance.classes();
-    JsonArray classes_array = doc_info["classes"].to<JsonArray>();
-    for (const auto& classObj : classes) {
-      JsonArray class_array = classes_array.add<JsonArray>();
-      class_array.add(classObj.score);
-      class_array.add(classObj.target);
+// Encodes the latest INVOKE result into the next slot for core 1
+static void send_frame(SSCMA& instance) {
+  frame_seq++;
+  TxSlot* slot = tx_acquire();
+  slot->text = frame_mode != FRAME_MODE_BINARY;
+  if (frame_mode == FRAME_MODE_BINARY) {
+    slot->len = encode_binary_frame(instance, slot->data, sizeof(slot->data));
+  } else if (frame_mode == FRAME_MODE_PASSTHROUGH) {
+    slot->len = encode_passthrough_frame(instance, slot->data, sizeof(slot->data));
+  } else {
+    slot->len = encode_json_frame(instance, slot->data, sizeof(slot->data));
+  }
+  if (slot->len > 0) {
+#if _LOG
+    if (pcSerial && frame_mode != FRAME_MODE_BINARY) {
+      pcSerial.write(slot->data, slot->len);
     }
+#endif
+    tx_publish();
+  }
+}
 
-    // Process points
-    auto& points = instance.points();
-    JsonArray points_array = doc_info["points"].to<JsonArray>();
-    for (const auto& point : points) {
+// Frames already queued go out in the old format; the ESP32 accepts all of them at any time
+static void apply_frame_mode(uint8_t mode, uint8_t id) {
+  if (mode != frame_mode) {
+    frame_mode = mode;
+    AI.set_passthrough(frame_mode == FRAME_MODE_PASSTHROUGH);
+    safe_serial_print("frame mode: " + String(frame_mode));
+  }
+  ctrl_reply(id, CMD_OK, &frame_mode, sizeof(frame_mode));
+}
+
+// The largest JPEG of a resolution has to fit every buffer it passes through: the INVOKE
+// reply in rx_buf, a binary frame, and the image line of a JSON frame
+static bool image_fits(uint16_t width, uint16_t height) {
+  size_t jpeg = IMAGE_JPEG_MAX_SIZE(width, height);
+  size_t base64 = (jpeg + 2) / 3 * 4;
+  return base64 + JSON_BUFFER_SIZE < (size_t)SSCMA_MAX_RX_SIZE &&
+         jpeg + sizeof(FrameSectionHeader) + FRAME_META_BUFFER_SIZE <= FRAME_PROTO_MAX_PAYLOAD &&
+         base64 + JSON_BUFFER_SIZE <= TX_SLOT_SIZE;
+}
+
+// A resolution that does not fit is refused with CMD_ENOMEM and its size, after
+// going back to the last one that did
+static void apply_sensor(uint8_t opt, uint8_t id) {
+  uint16_t size[2] = {0, 0};
+  int ret = AI.set_sensor(opt, size[0], size[1]);
+  if (ret == CMD_OK && !image_fits(size[0], size[1])) {
+    uint16_t width, height;
+    AI.set_sensor(sensor_opt, width, height);
+    ret = CMD_ENOMEM;
+  } else if (ret == CMD_OK) {
+    sensor_opt = opt;
+  }
+  ctrl_reply(id, ret, size, ret == CMD_OK || ret == CMD_ENOMEM ? sizeof(size) : 0);
+  safe_serial_print("sensor opt " + String(opt) + ": " + size[0] + "x" + size[1] +
+                    (ret == CMD_ENOMEM ? ", too large" : ""));
+}
+
+static void set_link_baud(uint32_t baud) {
+  // Core 1 reads espSerial in loop1()
+  rp2040.idleOtherCore();
+  espSerial.end();
+  espSerial.begin(baud);
+  rp2040.resumeOtherCore();
+  link_baud = baud;
+  link_switch_time = millis();
+  safe_serial_print("link baud: " + String(baud));
+}
+
+static void apply_link_baud(uint32_t baud, uint8_t id) {
+  confirmed_baud = 0;
+
+  // Reply at the old rate, the ESP32 switches when it sees it
+  ctrl_reply(id, CMD_OK, &baud, sizeof(baud));
+  tx_drain();
+  delay(LINK_SWITCH_GUARD_MS);
+  set_link_baud(baud);
+}
+
+static void check_link_baud(void) {
+  if (link_baud == ESP32_COMM_BAUD_RATE) {
+    return;
+  }
+  // Without a confirmation the ESP32 did not receive us at the new rate; it falls back on its own.
+  // Once confirmed, missing keepalives mean the ESP32 restarted at the base rate or lost a step-down request.
+  unsigned long now = millis();
+  bool lost = confirmed_baud != link_baud ? now - link_switch_time > LINK_CONFIRM_TIMEOUT_MS
+                                          : now - confirm_time > LINK_KEEPALIVE_TIMEOUT_MS;
+  if (lost) {
+    tx_drain();
+    set_link_baud(ESP32_COMM_BAUD_RATE);
+  }
+}
+
+// {"img":"..."} line; base64 needs no escaping, so copy it instead of going through a JsonDocument
+static size_t encode_image_line(const image_view_t& image, uint8_t* out, size_t size) {
+  static const char img_open[] = "{\"img\":\"";
+  static const char img_close[] = "\"}\r\n";
+  size_t len = sizeof(img_open) - 1 + image.len + sizeof(img_close) - 1;
+  if (image.len == 0 || len > size) {
+    return 0;
+  }
+  memcpy(out, img_open, sizeof(img_open) - 1);
+  memcpy(out + sizeof(img_open) - 1, image.data, image.len);
+  memcpy(out + len - (sizeof(img_close) - 1), img_close, sizeof(img_close) - 1);
+  return len;
+}
+
+// Same bytes as serializeJson() + println() of {"img":...} and doc_info
+static size_t encode_json_frame(SSCMA& instance, uint8_t* out, size_t size) {
+  doc_info.clear();
+
+  // Sequence number and model timing, for latency tracing on the ESP32
+  doc_info["seq"] = frame_seq;
+  perf_t& perf = instance.perf();
+  JsonArray perf_array = doc_info["perf"].to<JsonArray>();
+  perf_array.add(perf.prepocess);
+  perf_array.add(perf.inference);
+  perf_array.add(perf.postprocess);
+  
+  // Process boxes
+  auto& boxes = instance.boxes();
+  JsonArray boxes_array = doc_info["boxes"].to<JsonArray>();
+  for (const auto& box : boxes) {
+    JsonArray box_array = boxes_array.add<JsonArray>();
+    box_array.add(box.x);
+    box_array.add(box.y);
+    box_array.add(box.w);
+    box_array.add(box.h);
+    box_array.add(box.score);
+    box_array.add(box.target);
+  }
+
+  // Process classes
+  auto& classes = instance.classes();
+  JsonArray classes_array = doc_info["classes"].to<JsonArray>();
+  for (const auto& classObj : classes) {
+    JsonArray class_array = classes_array.add<JsonArray>();
+    class_array.add(classObj.score);
+    class_array.add(classObj.target);
+  }
+
+  // Process points
+  auto& points = instance.points();
+  JsonArray points_array = doc_info["points"].to<JsonArray>();
+  for (const auto& point : points) {
+    JsonArray point_array = points_array.add<JsonArray>();
+    point_array.add(point.x);
+    point_array.add(point.y);
+    point_array.add(point.score);
+    point_array.add(point.target);
+  }
+
+  // Process keypoints
+  auto& keypoints = instance.keypoints();
+  JsonArray keypoints_array = doc_info["keypoints"].to<JsonArray>();
+  for (const auto& keypoint : keypoints) {
+    JsonObject kp_obj = keypoints_array.add<JsonObject>();
+    
+    JsonArray box_array = kp_obj["box"].to<JsonArray>();
+    box_array.add(keypoint.box.x);
+    box_array.add(keypoint.box.y);
+    box_array.add(keypoint.box.w);
+    box_array.add(keypoint.box.h);
+    box_array.add(keypoint.box.score);
+    box_array.add(keypoint.box.target);
+    
+    JsonArray points_array = kp_obj["points"].to<JsonArray>();
+    for (const auto& point : keypoint.points) {
       JsonArray point_array = points_array.add<JsonArray>();
       point_array.add(point.x);
       point_array.add(point.y);
       point_array.add(point.score);
-      point_array.add(point.target);
     }
+  }
+  
+  // Image line first
+  size_t len = encode_image_line(instance.last_image(), out, size);
 
-    // Process keypoints
-    auto& keypoints = instance.keypoints();
-    JsonArray keypoints_array = doc_info["keypoints"].to<JsonArray>();
-    for (const auto& keypoint : keypoints) {
-      JsonObject kp_obj = keypoints_array.add<JsonObject>();
-      
-      JsonArray box_array = kp_obj["box"].to<JsonArray>();
-      box_array.add(keypoint.box.x);
-      box_array.add(keypoint.box.y);
-      box_array.add(keypoint.box.w);
-      box_array.add(keypoint.box.h);
-      box_array.add(keypoint.box.score);
-      box_array.add(keypoint.box.target);
-      
-      JsonArray points_array = kp_obj["points"].to<JsonArray>();
-      for (const auto& point : keypoint.points) {
-        JsonArray point_array = points_array.add<JsonArray>();
-        point_array.add(point.x);
-        point_array.add(point.y);
-        point_array.add(point.score);
-      }
+  // Results line; serializeJson() also writes a terminator, overwritten by "\r\n"
+  if (!doc_info.isNull() && doc_info.size() > 0) {
+    size_t info_len = measureJson(doc_info);
+    if (len + info_len + 2 <= size) {
+      serializeJson(doc_info, (char*)out + len, size - len);
+      len += info_len;
+      out[len++] = '\r';
+      out[len++] = '\n';
     }
-    
-    // Process image data
-    auto lastImage = instance.last_image();
-    if (lastImage.length() > 0) {
-      doc_image.clear();
-      doc_image["img"] = lastImage;
-      
-      if (serializeJson(doc_image, espSerial) > 0) {
-        espSerial.println();
-      }
-      
-#if _LOG
-      if (pcSerial && serializeJson(doc_image, pcSerial) > 0) {
-        pcSerial.println();
-      }
-#endif
+  }
+  return len;
+}
+
+/************************ Passthrough frame ****************************/
+// The same two lines as encode_json_frame(), but the results line is the INVOKE
+// data object as SSCMA sent it, with "seq" in place of "image":
+//   {"img":"..."}\r\n{"seq":N,"count":..,"boxes":[[x,y,w,h,score,target]],...}\r\n
+// Keypoints keep the SSCMA layout [box, points], which the ESP32 parses as well.
+static size_t encode_passthrough_frame(SSCMA& instance, uint8_t* out, size_t size) {
+  image_view_t image = instance.last_image();
+  image_view_t data = instance.last_data();
+  size_t len = encode_image_line(image, out, size);
+
+  // Cut "image":"..." and one comma next to it out of data
+  const char* head_end = data.data + data.len;
+  const char* tail = head_end;
+  if (image.len > 0) {
+    const char* member = image.data - 1;  // opening quote of the value
+    while (member > data.data && member[-1] != ',') {
+      member--;
     }
-    
-    // Send processed data
-    if (!doc_info.isNull() && doc_info.size() > 0) {
-      if (serializeJson(doc_info, espSerial) > 0) {
-        espSerial.println();
+    tail = image.data + image.len + 1;
+    if (member > data.data) {
+      head_end = member - 1;
+    } else {
+      head_end = member;
+      while (tail < data.data + data.len && (*tail == ' ' || *tail == ',')) {
+        tail++;
       }
-      
-#if _LOG
-      if (pcSerial && serializeJson(doc_info, pcSerial) > 0) {
-        pcSerial.println();
+    }
+  }
+  size_t head_len = head_end - data.data;
+  size_t tail_len = data.data + data.len - tail;
+
+  char seq[16];
+  int seq_len = snprintf(seq, sizeof(seq), "{\"seq\":%u", frame_seq);
+  bool more = head_len + tail_len > 0;
+  if (len + seq_len + more + head_len + tail_len + 3 > size) {
+    return len;
+  }
+  uint8_t* p = out + len;
+  memcpy(p, seq, seq_len);
+  p += seq_len;
+  if (more) {
+    *p++ = ',';
+    memcpy(p, data.data, head_len);
+    p += head_len;
+    memcpy(p, tail, tail_len);
+    p += tail_len;
+  }
+  *p++ = '}';
+  *p++ = '\r';
+  *p++ = '\n';
+  return p - out;
+}
+
+/************************ Binary frame ****************************/
+static inline uint8_t* put_u16(uint8_t* p, uint16_t v) {
+  p[0] = v & 0xFF;
+  p[1] = v >> 8;
+  return p + 2;
+}
+
+static inline uint8_t* put_box(uint8_t* p, const boxes_t& box) {
+  p = put_u16(p, box.x);
+  p = put_u16(p, box.y);
+  p = put_u16(p, box.w);
+  p = put_u16(p, box.h);
+  *p++ = box.score;
+  *p++ = box.target;
+  return p;
+}
+
+// Opens a section in frame_meta_buf, returns NULL if it would not fit
+static uint8_t* begin_section(uint8_t* p, size_t need) {
+  if (p + sizeof(FrameSectionHeader) + need > frame_meta_buf + sizeof(frame_meta_buf)) {
+    return NULL;
+  }
+  return p + sizeof(FrameSectionHeader);
+}
+
+static uint8_t* end_section(uint8_t* start, uint8_t* end, FrameSection type) {
+  FrameSectionHeader hdr = {type, 0, (uint16_t)(end - start - sizeof(FrameSectionHeader))};
+  memcpy(start, &hdr, sizeof(hdr));
+  return end;
+}
+
+static size_t encode_binary_frame(SSCMA& instance, uint8_t* out, size_t size) {
+  uint8_t* p = frame_meta_buf;
+  uint8_t* q;
+
+  // perf
+  if ((q = begin_section(p, 6)) != NULL) {
+    perf_t& perf = instance.perf();
+    q = put_u16(q, perf.prepocess);
+    q = put_u16(q, perf.inference);
+    q = put_u16(q, perf.postprocess);
+    p = end_section(p, q, FRAME_SEC_PERF);
+  }
+
+  // boxes
+  auto& boxes = instance.boxes();
+  if (!boxes.empty() && (q = begin_section(p, boxes.size() * 10)) != NULL) {
+    for (const auto& box : boxes) {
+      q = put_box(q, box);
+    }
+    p = end_section(p, q, FRAME_SEC_BOXES);
+  }
+
+  // classes
+  auto& classes = instance.classes();
+  if (!classes.empty() && (q = begin_section(p, classes.size() * 2)) != NULL) {
+    for (const auto& classObj : classes) {
+      *q++ = classObj.target;
+      *q++ = classObj.score;
+    }
+    p = end_section(p, q, FRAME_SEC_CLASSES);
+  }
+
+  // points
+  auto& points = instance.points();
+  if (!points.empty() && (q = begin_section(p, points.size() * 6)) != NULL) {
+    for (const auto& point : points) {
+      q = put_u16(q, point.x);
+      q = put_u16(q, point.y);
+      *q++ = point.score;
+      *q++ = point.target;
+    }
+    p = end_section(p, q, FRAME_SEC_POINTS);
+  }
+
+  // keypoints
+  auto& keypoints = instance.keypoints();
+  size_t kp_size = 0;
+  for (const auto& keypoint : keypoints) {
+    kp_size += 11 + min(keypoint.points.size(), (size_t)255) * 5;
+  }
+  if (!keypoints.empty() && (q = begin_section(p, kp_size)) != NULL) {
+    for (const auto& keypoint : keypoints) {
+      size_t count = min(keypoint.points.size(), (size_t)255);
+      q = put_box(q, keypoint.box);
+      *q++ = count;
+      for (size_t i = 0; i < count; i++) {
+        q = put_u16(q, keypoint.points[i].x);
+        q = put_u16(q, keypoint.points[i].y);
+        *q++ = keypoint.points[i].score;
       }
-#endif
     }
+    p = end_section(p, q, FRAME_SEC_KEYPOINTS);
+  }
+  size_t meta_len = p - frame_meta_buf;
+
+  // image: the raw JPEG instead of base64, decoded straight into the slot
+  FrameHeader header = {{FRAME_PROTO_MAGIC0, FRAME_PROTO_MAGIC1}, FRAME_PROTO_VERSION, 0, frame_seq, 0, 0};
+  FrameSectionHeader jpeg_hdr = {FRAME_SEC_JPEG, 0, 0};
+  uint8_t* jpeg = out + sizeof(header) + sizeof(jpeg_hdr);
+  size_t fixed = sizeof(header) + sizeof(jpeg_hdr) + meta_len + sizeof(uint32_t);
+  size_t jpeg_max = min(size - fixed, (size_t)FRAME_PROTO_MAX_PAYLOAD - sizeof(jpeg_hdr) - meta_len);
+  size_t jpeg_len = 0;
+  image_view_t image = instance.last_image();
+  if (image.len > 0 && GetDecodeExpectedLen(image.len) <= jpeg_max) {
+    jpeg_len = DecodeChunk(image.data, image.len, jpeg);
+  }
+  jpeg_hdr.len = jpeg_len;
+  header.payload_len = meta_len + (jpeg_len ? sizeof(jpeg_hdr) + jpeg_len : 0);
+
+  // JPEG first so the ESP32 can start decoding before the overlays
+  uint8_t* p_out = out;
+  memcpy(p_out, &header, sizeof(header));
+  p_out += sizeof(header);
+  if (jpeg_len) {
+    memcpy(p_out, &jpeg_hdr, sizeof(jpeg_hdr));
+    p_out += sizeof(jpeg_hdr) + jpeg_len;
   }
+  memcpy(p_out, frame_meta_buf, meta_len);
+  p_out += meta_len;
+  uint32_t crc = frame_crc32(0, out, p_out - out);
+  memcpy(p_out, &crc, sizeof(crc));
+  return p_out + sizeof(crc) - out;
 }
 
 /************************ Model title handling ****************************/
-static inline void send_model_title(SSCMA& instance) {
+static inline void send_model_title(SSCMA& instance, uint8_t id) {
 #if _LOG
   safe_serial_print("request model title");
 #endif
@@ -322,6 +1013,7 @@ static inline void send_model_title(SSCMA& instance) {
   // Fixed: Check for empty string, not negative length
   if (base64String.length() == 0) {
     safe_serial_print("Empty base64 string received");
+    ctrl_reply(id, CMD_EIO);
     return;
   }
 
@@ -332,6 +1024,7 @@ static inline void send_model_title(SSCMA& instance) {
   // 检查合理的缓冲区大小
   if (input_length > 4096 || expected_length > 2048) {
     safe_serial_print("Base64 string too large");
+    ctrl_reply(id, CMD_ENOMEM);
     return;
   }
   
@@ -339,6 +1032,7 @@ static inline void send_model_title(SSCMA& instance) {
   
   if (!decoded_string) {
     safe_serial_print("Memory allocation failed");
+    ctrl_reply(id, CMD_ENOMEM);
     return;
   }
   
@@ -351,19 +1045,12 @@ static inline void send_model_title(SSCMA& instance) {
   
   if (error) {
     safe_serial_print("JSON deserialization failed");
+    ctrl_reply(id, CMD_EINVAL);
   } else {
-    JsonDocument send_doc;
-    send_doc["name"] = doc["name"];
-    
-    if (serializeJson(send_doc, espSerial) > 0) {
-      espSerial.println();
-    }
-    
-#if _LOG
-    if (pcSerial && serializeJson(send_doc, pcSerial) > 0) {
-      pcSerial.println();
-    }
-#endif
+    // The name without a terminator, cut to CTRL_PAYLOAD_SIZE
+    const char* name = doc["name"] | "";
+    ctrl_reply(id, CMD_OK, name, strlen(name));
+    safe_serial_print(String("model: ") + name);
   }
   
   // 清理动态分配的内存
@@ -86,6 +86,21 @@ SSCMA::SSCMA()
     _sync = -1;
     tx_len = 0;
     rx_len = 0;
+
+    // The image is located in rx_buf by praser_event() instead of being copied into response
+    response_filter["*"] = true;
+    response_filter["data"]["*"] = true;
+    response_filter["data"]["image"] = false;
+
+    // In passthrough mode all of INVOKE data is, other replies still use response_filter
+    invoke_filter["*"] = true;
+    invoke_filter["data"] = false;
+}
+
+void SSCMA::set_passthrough(bool on)
+{
+    _passthrough = on;
+    _data.len = 0;
 }
 
 SSCMA::~SSCMA() {}
@@ -442,10 +457,104 @@ int SSCMA::spi_write(const char *data, int length)
     return length;
 }
 
-void SSCMA::praser_event()
+// Finds "image": "..." in the raw reply
+static bool find_image(const char *reply, size_t len, image_view_t *image)
+{
+    const char *end = reply + len;
+    const char *p = strnstr(reply, "\"image\"", len);
+    if (!p)
+    {
+        return false;
+    }
+    p += sizeof("\"image\"") - 1;
+    while (p < end && (*p == ' ' || *p == ':'))
+    {
+        p++;
+    }
+    if (p >= end || *p != '"')
+    {
+        return false;
+    }
+    p++;
+    const char *q = (const char *)memchr(p, '"', end - p);
+    if (!q)
+    {
+        return false;
+    }
+    image->data = p;
+    image->len = q - p;
+    return true;
+}
+
+// Finds "data": {...} in the raw reply, returns what is between the braces
+static bool find_data(const char *reply, size_t len, image_view_t *data)
+{
+    const char *end = reply + len;
+    const char *p = strnstr(reply, "\"data\"", len);
+    if (!p)
+    {
+        return false;
+    }
+    p += sizeof("\"data\"") - 1;
+    while (p < end && (*p == ' ' || *p == ':'))
+    {
+        p++;
+    }
+    if (p >= end || *p != '{')
+    {
+        return false;
+    }
+
+    const char *start = ++p;
+    int depth = 1;
+    while (p < end)
+    {
+        char c = *p++;
+        if (c == '"')
+        {
+            // strings are skipped whole, the image with a single memchr
+            const char *q = p;
+            while ((q = (const char *)memchr(q, '"', end - q)) && q[-1] == '\\')
+            {
+                q++;
+            }
+            if (!q)
+            {
+                return false;
+            }
+            p = q + 1;
+        }
+        else if (c == '{' || c == '[')
+        {
+            depth++;
+        }
+        else if ((c == '}' || c == ']') && --depth == 0)
+        {
+            data->data = start;
+            data->len = p - 1 - start;
+            return true;
+        }
+    }
+    return false;
+}
+
+void SSCMA::praser_event(const char *reply, size_t len)
 {
     if (strstr(response["name"], CMD_AT_INVOKE))
     {
+        if (_passthrough)
+        {
+            if (!find_data(reply, len, &_data))
+            {
+                _data.len = 0;
+            }
+            if (_data.len == 0 || !find_image(_data.data, _data.len, &_image))
+            {
+                _image.len = 0;
+            }
+            return;
+        }
+
         if (response["data"]["perf"].is<JsonArray>())
         {
             _perf.prepocess = response["data"]["perf"][0];
@@ -531,9 +640,9 @@ void SSCMA::praser_event()
                 _keypoints.push_back(k);
             }
         }
-        if (!response["data"]["image"].isNull())
+        if (!find_image(reply, len, &_image))
         {
-            _image = response["data"]["image"].as<String>();
+            _image.len = 0;
         }
     }
 }
@@ -541,81 +650,124 @@ void SSCMA::praser_log()
 {
 }
 
-int SSCMA::wait(int type, const char *cmd, uint32_t timeout)
+// Appends what the device has to rx_buf. Replies are consumed in place, so the
+// buffer only moves when it is full, and then only the unfinished reply.
+int SSCMA::rx_fill()
 {
-    int ret = CMD_OK;
-    unsigned long startTime = millis();
-    while (millis() - startTime <= timeout)
+    int len = available();
+    if (len == 0)
+        return 0;
+
+    if (rx_start == rx_end)
+    {
+        rx_start = rx_scan = rx_end = 0;
+        _image.len = 0;
+        _data.len = 0;
+    }
+    if ((uint32_t)len + rx_end + 1 > this->rx_len && rx_start > 0)
     {
-        int len = available();
-        if (len == 0)
-            continue;
-        if (len + rx_end > this->rx_len)
+        memmove(rx_buf, rx_buf + rx_start, rx_end - rx_start);
+        rx_end -= rx_start;
+        rx_scan -= rx_start;
+        rx_start = 0;
+        _image.len = 0;
+        _data.len = 0;
+    }
+    if ((uint32_t)len + rx_end + 1 > this->rx_len)
+    {
+        len = this->rx_len - rx_end - 1;
+        if (len <= 0)
         {
-            len = this->rx_len - rx_end;
-            if (len <= 0)
-            {
-                rx_end = 0;
-                continue;
-            }
+            // a reply larger than the buffer, drop it
+            rx_start = rx_scan = rx_end = 0;
+            return 0;
         }
+    }
 
-        rx_end += read(rx_buf + rx_end, len);
-        rx_buf[rx_end] = '\0';
+    len = read(rx_buf + rx_end, len);
+    rx_end += len;
+    _rx_total += len;
+    rx_buf[rx_end] = '\0';
+    return len;
+}
 
-        while (char *suffix = strnstr(rx_buf, RESPONSE_SUFFIX, rx_end))
+// Returns the next complete "\r{...}\n" reply; bytes already searched are not searched again
+bool SSCMA::rx_next(char **reply, size_t *len)
+{
+    while (rx_scan < rx_end)
+    {
+        char *suffix = strnstr(rx_buf + rx_scan, RESPONSE_SUFFIX, rx_end - rx_scan);
+        if (!suffix)
         {
-            if (char *prefix = strnstr(rx_buf, RESPONSE_PREFIX, suffix - rx_buf))
-            {
-                // get json payload
-                len = suffix - prefix + RESPONSE_SUFFIX_LEN;
-                payload = (char *)malloc(len);
+            // the suffix may be split across reads
+            rx_scan = rx_end - rx_start > RESPONSE_SUFFIX_LEN - 1 ? rx_end - (RESPONSE_SUFFIX_LEN - 1) : rx_start;
+            return false;
+        }
 
-                if (!payload)
-                {
-                    continue;
-                }
+        char *start = rx_buf + rx_start;
+        char *prefix = strnstr(start, RESPONSE_PREFIX, suffix - start);
+        rx_start = rx_scan = suffix + RESPONSE_SUFFIX_LEN - rx_buf;
+        if (prefix)
+        {
+            *reply = prefix;
+            *len = suffix + RESPONSE_SUFFIX_LEN - prefix;
+            return true;
+        }
+        // discard this reply
+    }
+    return false;
+}
 
-                memcpy(payload, prefix + 1, len - 1); // remove "\r" and "\n"
-                memmove(rx_buf, suffix + RESPONSE_SUFFIX_LEN, rx_end - (suffix - rx_buf) - RESPONSE_SUFFIX_LEN);
-                rx_end -= suffix - rx_buf + RESPONSE_SUFFIX_LEN;
-                payload[len - 1] = '\0';
-                //Serial.printf("\npayload :%s", payload);
-                // parse json response
-                // for(size_t i = 0; i < strlen(payload); i++){
-                //     Serial.printf("%c", payload[i]);
-                // }
-                response.clear();
-                DeserializationError error = deserializeJson(response, payload);
-                free(payload);
-                if (error)
-                {
-                    continue;
-                }
+// Deserializes one reply into response and handles events and logs
+bool SSCMA::parse_reply(const char *reply, size_t len)
+{
+    // "name" comes before "data", the prefix is enough to recognize INVOKE replies
+    bool raw_data = _passthrough && strnstr(reply, "\"INVOKE\"",
+                                            len < SSCMA_NAME_SCAN ? len : SSCMA_NAME_SCAN);
 
-                if (response["type"] == CMD_TYPE_EVENT)
-                {
-                    praser_event();
-                }
+    // parse json response, without "\r" and "\n"
+    response.clear();
+    DeserializationError error = deserializeJson(response, reply + 1, len - 2,
+                                                 DeserializationOption::Filter(raw_data ? invoke_filter : response_filter));
+    if (error)
+    {
+        return false;
+    }
 
-                if (response["type"] == CMD_TYPE_LOG)
-                {
-                    praser_log();
-                }
+    if (response["type"] == CMD_TYPE_EVENT)
+    {
+        praser_event(reply, len);
+    }
 
-                ret = response["code"];
+    if (response["type"] == CMD_TYPE_LOG)
+    {
+        praser_log();
+    }
+    return true;
+}
 
-                if (response["type"] == type && strncmp(response["name"], cmd, sizeof(cmd)) == 0)
-                {
-                    return ret;
-                }
+int SSCMA::wait(int type, const char *cmd, uint32_t timeout)
+{
+    int ret = CMD_OK;
+    unsigned long startTime = millis();
+    char *reply;
+    size_t len;
+    while (millis() - startTime <= timeout)
+    {
+        rx_fill();
+
+        while (rx_next(&reply, &len))
+        {
+            if (!parse_reply(reply, len))
+            {
+                continue;
             }
-            else
+
+            ret = response["code"];
+
+            if (response["type"] == type && strncmp(response["name"], cmd, sizeof(cmd)) == 0)
             {
-                // discard this reply
-                memmove(rx_buf, suffix + RESPONSE_PREFIX_LEN, rx_end - (suffix - rx_buf) - RESPONSE_PREFIX_LEN);
-                rx_end -= suffix - rx_buf + RESPONSE_PREFIX_LEN;
-                rx_buf[rx_end] = '\0';
+                return ret;
             }
         }
     }
@@ -625,56 +777,43 @@ int SSCMA::wait(int type, const char *cmd, uint32_t timeout)
 
 void SSCMA::fetch(ResponseCallback RespCallback)
 {
-    int len = available();
-    if (len == 0)
-        return;
-    if (len + rx_end > this->rx_len)
+    char *reply;
+    size_t len;
+
+    rx_fill();
+
+    while (rx_next(&reply, &len))
     {
-        len = this->rx_len - rx_end;
-        if (len <= 0)
+        if (RespCallback)
         {
-            rx_end = 0;
-            return;
+            // terminate in place for the callback
+            char saved = reply[len];
+            reply[len] = '\0';
+            RespCallback(reply, len);
+            reply[len] = saved;
         }
     }
-    // Serial.print("available : ");
-    // Serial.println(len);
-
-    rx_end += read(rx_buf + rx_end, len);
-    rx_buf[rx_end] = '\0';
+}
 
-    while (char *suffix = strnstr(rx_buf, RESPONSE_SUFFIX, rx_end))
-    {
-        if (char *prefix = strnstr(rx_buf, RESPONSE_PREFIX, suffix - rx_buf))
+int SSCMA::fetch_invoke(InvokeCallback callback)
+{
+    int events = 0;
+    fetch([&](const char *resp, size_t len) {
+        if (parse_reply(resp, len) && response["type"] == CMD_TYPE_EVENT &&
+            response["name"] == CMD_AT_INVOKE && response["code"] == CMD_OK)
         {
-            // get json payload
-            len = suffix - prefix + RESPONSE_SUFFIX_LEN;
-            payload = (char *)malloc(len + 1);
-
-            if (!payload)
+            events++;
+            if (callback)
             {
-                continue;
+                callback();
             }
-
-            memcpy(payload, prefix, len); // remove "\r" and "\n"
-            memmove(rx_buf, suffix + RESPONSE_SUFFIX_LEN, rx_end - (suffix - rx_buf) - RESPONSE_SUFFIX_LEN);
-            rx_end -= suffix - rx_buf + RESPONSE_SUFFIX_LEN;
-            payload[len] = '\0';
-            if (RespCallback)
-                RespCallback(payload, len);
-            free(payload);
         }
-        else
-        {
-            // discard this reply
-            memmove(rx_buf, suffix + RESPONSE_PREFIX_LEN, rx_end - (suffix - rx_buf) - RESPONSE_PREFIX_LEN);
-            rx_end -= suffix - rx_buf + RESPONSE_PREFIX_LEN;
-            rx_buf[rx_end] = '\0';
-        }
-    }
+    });
+    return events;
 }
 
-int SSCMA::invoke(int times, bool filter, bool show)
+// Sends AT+INVOKE and waits for the command response, not for the event
+int SSCMA::send_invoke(int times, bool filter, bool show)
 {
     char cmd[64] = {0};
 
@@ -690,7 +829,18 @@ int SSCMA::invoke(int times, bool filter, bool show)
     // Serial.print("cmd: ");
     // Serial.print(cmd);
 
-    if (wait(CMD_TYPE_RESPONSE, CMD_AT_INVOKE) == CMD_OK)
+    return wait(CMD_TYPE_RESPONSE, CMD_AT_INVOKE);
+}
+
+int SSCMA::invoke(int times, bool filter, bool show)
+{
+    int ret = send_invoke(times, filter, show);
+    if (ret == CMD_ENOTSUP)
+    {
+        return ret;
+    }
+
+    if (ret == CMD_OK)
     {
         if (wait(CMD_TYPE_EVENT, CMD_AT_INVOKE) == CMD_OK)
         {
@@ -701,6 +851,24 @@ int SSCMA::invoke(int times, bool filter, bool show)
     return CMD_ETIMEDOUT;
 }
 
+int SSCMA::invoke_start(bool filter, bool show)
+{
+    int ret = send_invoke(-1, filter, show);
+    _streaming = ret == CMD_OK;
+    return ret;
+}
+
+int SSCMA::invoke_stop()
+{
+    char cmd[64] = {0};
+    snprintf(cmd, sizeof(cmd), CMD_PREFIX "%s" CMD_SUFFIX, CMD_AT_BREAK);
+    write(cmd, strlen(cmd));
+
+    // Events already on the way are parsed and dropped while waiting
+    _streaming = false;
+    return wait(CMD_TYPE_RESPONSE, CMD_AT_BREAK);
+}
+
 int SSCMA::WIFI(wifi_t &wifi)
 {
     char cmd[64] = {0};
@@ -865,7 +1033,9 @@ bool SSCMA::set_rx_buffer(uint32_t size)
     }
     if (this->rx_buf)
     {
-        this->rx_end = 0;
+        this->rx_start = this->rx_scan = this->rx_end = 0;
+        _image.len = 0;
+        _data.len = 0;
         this->rx_len = size;
     }
     return this->rx_buf != NULL;
@@ -891,6 +1061,61 @@ bool SSCMA::set_tx_buffer(uint32_t size)
     return this->tx_buf != nullptr;
 }
 
+int SSCMA::set_param(const char *name, int value, uint32_t timeout)
+{
+    char cmd[64] = {0};
+    snprintf(cmd, sizeof(cmd), CMD_PREFIX "%s=%d" CMD_SUFFIX, name, value);
+
+    write(cmd, strlen(cmd));
+    return wait(CMD_TYPE_RESPONSE, name, timeout);
+}
+
+int SSCMA::set_model(uint8_t id)
+{
+    // Loading the model takes a while on the module
+    int ret = set_param(CMD_AT_MODEL, id, 3000);
+    if (ret == CMD_OK)
+    {
+        _info = "";
+    }
+    return ret;
+}
+
+int SSCMA::set_tscore(uint8_t score)
+{
+    return set_param(CMD_AT_TSCORE, score);
+}
+
+int SSCMA::set_tiou(uint8_t iou)
+{
+    return set_param(CMD_AT_TIOU, iou);
+}
+
+int SSCMA::set_sensor(uint8_t opt, uint16_t &width, uint16_t &height)
+{
+    char cmd[64] = {0};
+    // Sensor 1 is the camera on the Grove Vision AI V2
+    snprintf(cmd, sizeof(cmd), CMD_PREFIX "%s=1,1,%d" CMD_SUFFIX, CMD_AT_SENSOR, opt);
+
+    write(cmd, strlen(cmd));
+    int ret = wait(CMD_TYPE_RESPONSE, CMD_AT_SENSOR, 3000);
+    if (ret != CMD_OK)
+    {
+        return ret;
+    }
+
+    // "opt_detail": "240x240 Auto"
+    const char *detail = response["data"]["sensor"]["opt_detail"] | "";
+    unsigned int w = 0, h = 0;
+    if (sscanf(detail, "%ux%u", &w, &h) != 2)
+    {
+        return CMD_EUNKNOWN;
+    }
+    width = w;
+    height = h;
+    return CMD_OK;
+}
+
 int SSCMA::clean_actions()
 {
     char cmd[64] = {0};
@@ -89,6 +89,7 @@
 
 #define RESPONSE_PREFIX_LEN (sizeof(RESPONSE_PREFIX) - 1)
 #define RESPONSE_SUFFIX_LEN (sizeof(RESPONSE_SUFFIX) - 1)
+#define SSCMA_NAME_SCAN 48 // bytes of a reply searched for its "name"
 
 #define CMD_PREFIX "AT+"
 #define CMD_SUFFIX "\r\n"
@@ -120,6 +121,7 @@ const char CMD_AT_ALGOS[] = "ALGOS";
 const char CMD_AT_MODELS[] = "MODELS";
 const char CMD_AT_MODEL[] = "MODEL";
 const char CMD_AT_SENSORS[] = "SENSORS";
+const char CMD_AT_SENSOR[] = "SENSOR";
 const char CMD_AT_ACTION[] = "ACTION";
 const char CMD_AT_LED[] = "led";
 const char CMD_AT_SAVE_JPEG[] = "save_jpeg()";
@@ -146,6 +148,7 @@ const char LOG_AT[] = "AT";
 const char LOG_LOG[] = "LOG";
 
 typedef std::function<void(const char *resp, size_t len)> ResponseCallback;
+typedef std::function<void(void)> InvokeCallback;
 
 typedef struct
 {
@@ -178,6 +181,14 @@ typedef struct
     std::vector<point_t> points;
 } keypoints_t;
 
+// Slice of the receive buffer, not '\0'-terminated: the base64 JPEG, or the
+// INVOKE data object in passthrough mode
+typedef struct
+{
+    const char *data;
+    size_t len;
+} image_view_t;
+
 typedef struct
 {
     uint16_t prepocess;
@@ -239,22 +250,33 @@ private:
     char _name[32] = {0};
     char _ID[32] = {0};
 
+    // rx_buf: [consumed | rx_start: unfinished reply | rx_end: free]
+    // Replies are parsed in place; rx_scan is where the search for the next suffix resumes
+    uint32_t rx_start = 0;
+    uint32_t rx_scan = 0;
     uint32_t rx_end = 0;
 
 #if ARDUINOJSON_VERSION_MAJOR == 7
     JsonDocument response; // for json response
+    JsonDocument response_filter; // everything but the image
+    JsonDocument invoke_filter; // INVOKE replies in passthrough mode, without data
 #else
     StaticJsonDocument<2048> response; // for json response
+    StaticJsonDocument<128> response_filter; // everything but the image
+    StaticJsonDocument<64> invoke_filter; // INVOKE replies in passthrough mode, without data
 #endif
 
-    String _image = "";
+    bool _passthrough = false;
+    bool _streaming = false; // AT+INVOKE=-1 is running
+    uint32_t _rx_total = 0;  // bytes read from the device, for transport benchmarks
+    image_view_t _image = {NULL, 0};
+    image_view_t _data = {NULL, 0};
     String _info = "";
 
     char *tx_buf; // for cmd
     uint32_t tx_len;
     char *rx_buf; // for response
     uint32_t rx_len;
-    char *payload; // for json payload
 
 public:
     SSCMA();
@@ -267,11 +289,19 @@ public:
     bool begin(SPIClass *spi, int32_t cs = -1, int32_t sync = -1, int32_t rst = -1,
                uint32_t baud = SSCMA_SPI_CLOCK, uint32_t wait_delay = 2);
     int invoke(int times = 1, bool filter = 0, bool show = 0);
+    // Continuous invoke: the module streams INVOKE events at its own rate until
+    // invoke_stop(), collect them with fetch_invoke()
+    int invoke_start(bool filter = 0, bool show = 0);
+    int invoke_stop();
+    bool streaming() { return _streaming; }
     int available();
     int read(char *data, int length);
     int write(const char *data, int length);
     void reset();
     void fetch(ResponseCallback RespCallback);
+    // Parses what has arrived and calls callback once per successful INVOKE
+    // event, with perf(), boxes(), last_image() etc. set for it; returns the count
+    int fetch_invoke(InvokeCallback callback);
 
     perf_t &perf() { return _perf; }
     std::vector<boxes_t> &boxes() { return _boxes; }
@@ -291,11 +321,28 @@ public:
     char *name(bool cache = true);
     String info(bool cache = true);
 
+    // parameters, 0-100 for the thresholds; set_model() also drops the cached info()
+    int set_model(uint8_t id);
+    int set_tscore(uint8_t score);
+    int set_tiou(uint8_t iou);
+    // Preview resolution: opt_id of the camera, see AT+SENSORS?; width and height
+    // are taken from the reply's opt_detail
+    int set_sensor(uint8_t opt, uint16_t &width, uint16_t &height);
+
     // actions
     int clean_actions();
     int save_jpeg();
 
-    String last_image() { return _image; }
+    // Valid until the next call that reads from the device
+    image_view_t last_image() { return _image; }
+    // Contents of the INVOKE data object without the braces, image included;
+    // only located in passthrough mode, same lifetime as last_image()
+    image_view_t last_data() { return _data; }
+
+    // Passthrough skips deserializing INVOKE data; boxes() etc. are then not updated
+    void set_passthrough(bool on);
+
+    uint32_t rx_total() { return _rx_total; }
 
     bool set_rx_buffer(uint32_t size);
     bool set_tx_buffer(uint32_t size);
@@ -311,8 +358,13 @@ private:
     int spi_available();
     void spi_cmd(uint8_t feature, uint8_t cmd, uint16_t len = 0, uint8_t *data = NULL);
 
+    int rx_fill();
+    bool rx_next(char **reply, size_t *len);
+    int send_invoke(int times, bool filter, bool show);
+    bool parse_reply(const char *reply, size_t len);
     int wait(int type, const char *cmd, uint32_t timeout = 1000);
-    void praser_event();
+    int set_param(const char *name, int value, uint32_t timeout = 1000);
+    void praser_event(const char *reply, size_t len);
     void praser_log();
 };
 
@@ -0,0 +1,75 @@
+/**
+ * @file frame_proto.h
+ * @date  16 October 2026
+
+ * @author Spencer Yan
+ *
+ * @note Binary frame format sent to the ESP32, must match main/esp32_rp2040/frame_proto.h
+ *
+ * @copyright © 2026, Seeed Studio
+ */
+
+#ifndef FRAME_PROTO_H
+#define FRAME_PROTO_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+/**
+ * Frame layout (little-endian):
+ *
+ *   FrameHeader | section | section | ... | crc32
+ *
+ * Each section is a FrameSectionHeader followed by `len` bytes. The CRC-32
+ * (IEEE) covers the header and the payload.
+ */
+#define FRAME_PROTO_MAGIC0 0xAA
+#define FRAME_PROTO_MAGIC1 0x55
+#define FRAME_PROTO_VERSION 1
+#define FRAME_PROTO_MAX_PAYLOAD (32 * 1024)
+
+enum FrameMode : uint8_t {
+  FRAME_MODE_JSON = 0,
+  FRAME_MODE_BINARY = 1,
+  FRAME_MODE_PASSTHROUGH = 2  // SSCMA INVOKE data forwarded as-is, still JSON lines
+};
+
+enum FrameSection : uint8_t {
+  FRAME_SEC_PERF = 0x01,       // 3 x u16: preprocess, inference, postprocess
+  FRAME_SEC_BOXES = 0x02,      // n x {u16 x, y, w, h; u8 score, target}
+  FRAME_SEC_CLASSES = 0x03,    // n x {u8 target, score}
+  FRAME_SEC_POINTS = 0x04,     // n x {u16 x, y; u8 score, target}
+  FRAME_SEC_KEYPOINTS = 0x05,  // n x {box; u8 count; count x {u16 x, y; u8 score}}
+  FRAME_SEC_JPEG = 0x06        // raw JPEG bytes
+};
+
+struct __attribute__((packed)) FrameHeader {
+  uint8_t magic[2];
+  uint8_t version;
+  uint8_t flags;
+  uint16_t seq;
+  uint16_t reserved;
+  uint32_t payload_len;
+};
+
+struct __attribute__((packed)) FrameSectionHeader {
+  uint8_t type;
+  uint8_t reserved;
+  uint16_t len;
+};
+
+// CRC-32 (IEEE 802.3), same result as esp_rom_crc32_le(0, ...) on the ESP32
+static inline uint32_t frame_crc32(uint32_t crc, const uint8_t* buf, size_t len) {
+  static const uint32_t table[16] = {
+    0x00000000, 0x1DB71064, 0x3B6E20C8, 0x26D930AC, 0x76DC4190, 0x6B6B51F4, 0x4DB26158, 0x5005713C,
+    0xEDB88320, 0xF00F9344, 0xD6D6A3E8, 0xCB61B38C, 0x9B64C2B0, 0x86D3D2D4, 0xA00AE278, 0xBDBDF21C
+  };
+  crc = ~crc;
+  for (size_t i = 0; i < len; i++) {
+    crc = table[(crc ^ buf[i]) & 0x0F] ^ (crc >> 4);
+    crc = table[(crc ^ (buf[i] >> 4)) & 0x0F] ^ (crc >> 4);
+  }
+  return ~crc;
+}
+
+#endif /*FRAME_PROTO_H*/
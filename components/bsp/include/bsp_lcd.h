@@ -7,6 +7,7 @@
 #pragma once
 
 #include <stdbool.h>
+#include <stdint.h>
 #include "esp_err.h"
 
 #ifdef __cplusplus
@@ -57,6 +58,41 @@ esp_err_t bsp_lcd_flush(int x1, int y1, int x2, int y2, const void *p_data);
  */
 esp_err_t bsp_lcd_set_cb(bool (*trans_done_cb)(void *), void *data);
 
+/**
+ * @brief Set callback function called from the RGB panel vsync ISR
+ *
+ * @note The callback runs in ISR context and must be placed in IRAM
+ *
+ * @param vsync_cb Callback function, return true to yield from the ISR
+ * @param data User data
+ * @return
+ *    - ESP_OK: Success
+ *    - Others: Fail
+ */
+esp_err_t bsp_lcd_set_vsync_cb(bool (*vsync_cb)(void *), void *data);
+
+/**
+ * @brief Get the number of vsync events since init
+ *
+ * @param time_us Optional, esp_timer_get_time() of the latest vsync
+ * @return Vsync count, wraps at 32 bits
+ */
+uint32_t bsp_lcd_get_vsync_count(int64_t *time_us);
+
+/**
+ * @brief Block until the vsync count reaches `count`
+ *
+ * @note Only one task can wait at a time. The caller's task notifications are left untouched.
+ *
+ * @param count Target count, compared with wrap-around
+ * @param timeout_ms Timeout in milliseconds
+ * @return
+ *    - ESP_OK: Count reached
+ *    - ESP_ERR_TIMEOUT: No vsync in time, e.g. the panel has no vsync event
+ *    - ESP_ERR_INVALID_STATE: Another task is waiting, or the LCD is not initialized
+ */
+esp_err_t bsp_lcd_wait_vsync(uint32_t count, uint32_t timeout_ms);
+
 /**
  * @brief Deinit LCD with SPI interface
  *
@@ -10,6 +10,7 @@
 #include "esp_compiler.h"
 #include "esp_log.h"
 #include "esp_check.h"
+#include "esp_timer.h"
 #include "esp_lcd_panel_io.h"
 #include "esp_lcd_panel_vendor.h"
 #include "esp_lcd_panel_ops.h"
@@ -44,6 +45,16 @@ static bool (*lvgl_direct_mode_buf_copy)(void) = NULL;
 
 static void *p_user_data = NULL;
 static bool (*p_on_trans_done_cb)(void *) = NULL;
+static void *p_vsync_user_data = NULL;
+static bool (*p_on_vsync_cb)(void *) = NULL;
+
+/* Vsync counter and the task waiting for it, see bsp_lcd_wait_vsync() */
+static volatile uint32_t vsync_count = 0;
+static volatile int64_t vsync_time = 0;
+static TaskHandle_t vsync_waiter = NULL;
+static SemaphoreHandle_t vsync_sem = NULL; /* Given once the waiter's target is reached */
+static uint32_t vsync_target = 0;
+static portMUX_TYPE vsync_lock = portMUX_INITIALIZER_UNLOCKED;
 
 static bool lcd_trans_done_cb(esp_lcd_panel_io_handle_t panel_io, esp_lcd_panel_io_event_data_t *user_data, void *event_data)
 {
@@ -85,11 +96,32 @@ IRAM_ATTR static bool on_vsync_event(
 )
 {
     BaseType_t high_task_awoken = pdFALSE;
+
+    portENTER_CRITICAL_ISR(&vsync_lock);
+    uint32_t count = vsync_count + 1;
+    vsync_count = count;
+    vsync_time = esp_timer_get_time();
+    TaskHandle_t waiter = vsync_waiter;
+    if (NULL != waiter && (int32_t)(count - vsync_target) >= 0) {
+        vsync_waiter = NULL;
+    } else {
+        waiter = NULL;
+    }
+    portEXIT_CRITICAL_ISR(&vsync_lock);
+    if (NULL != waiter) {
+        xSemaphoreGiveFromISR(vsync_sem, &high_task_awoken);
+    }
+
 #if CONFIG_LCD_AVOID_TEAR
     xSemaphoreGiveFromISR(trans_ready, &high_task_awoken);
     xSemaphoreGiveFromISR(flush_ready, &high_task_awoken);
 #endif
 
+    /* Call user registered function */
+    if (NULL != p_on_vsync_cb && p_on_vsync_cb(p_vsync_user_data)) {
+        high_task_awoken = pdTRUE;
+    }
+
     return high_task_awoken == pdTRUE;
 }
 
@@ -115,6 +147,9 @@ esp_err_t bsp_lcd_init(void)
         return ESP_OK;
     }
 
+    vsync_sem = xSemaphoreCreateBinary();
+    assert(vsync_sem);
+
     esp_lcd_panel_dev_config_t panel_config = {
         .reset_gpio_num = brd->GPIO_LCD_RST,
         .color_space = brd->LCD_COLOR_SPACE,
@@ -233,6 +268,9 @@ esp_err_t bsp_lcd_init(void)
                 .flags.pclk_active_neg = brd->PCLK_ACTIVE_NEG,
             },
             .flags.fb_in_psram = 1,
+#if CONFIG_LCD_LVGL_SRAM_STRIPE && ESP_IDF_VERSION >= ESP_IDF_VERSION_VAL(5, 0, 0)
+            .bounce_buffer_size_px = brd->LCD_WIDTH * CONFIG_LCD_RGB_BOUNCE_BUFFER_LINES,
+#endif
 #if CONFIG_LCD_AVOID_TEAR
             .flags.double_fb = 1,
             .flags.refresh_on_demand = 1,   // Mannually control refresh operation
@@ -349,6 +387,69 @@ esp_err_t bsp_lcd_set_cb(bool (*trans_done_cb)(void *), void *data)
     return ESP_OK;
 }
 
+esp_err_t bsp_lcd_set_vsync_cb(bool (*vsync_cb)(void *), void *data)
+{
+    if (esp_ptr_executable(vsync_cb)) {
+        p_vsync_user_data = data;
+        p_on_vsync_cb = vsync_cb;
+    } else {
+        ESP_LOGE(TAG, "Invalid function pointer");
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    return ESP_OK;
+}
+
+uint32_t bsp_lcd_get_vsync_count(int64_t *time_us)
+{
+    portENTER_CRITICAL(&vsync_lock);
+    uint32_t count = vsync_count;
+    if (NULL != time_us) {
+        *time_us = vsync_time;
+    }
+    portEXIT_CRITICAL(&vsync_lock);
+    return count;
+}
+
+esp_err_t bsp_lcd_wait_vsync(uint32_t count, uint32_t timeout_ms)
+{
+    if (NULL == vsync_sem) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    /* Drop a give left over from an earlier wait that timed out */
+    xSemaphoreTake(vsync_sem, 0);
+
+    portENTER_CRITICAL(&vsync_lock);
+    if ((int32_t)(vsync_count - count) >= 0) {
+        portEXIT_CRITICAL(&vsync_lock);
+        return ESP_OK;
+    }
+    if (NULL != vsync_waiter) {
+        portEXIT_CRITICAL(&vsync_lock);
+        return ESP_ERR_INVALID_STATE;
+    }
+    vsync_target = count;
+    vsync_waiter = xTaskGetCurrentTaskHandle();
+    portEXIT_CRITICAL(&vsync_lock);
+
+    if (xSemaphoreTake(vsync_sem, pdMS_TO_TICKS(timeout_ms)) == pdTRUE) {
+        return ESP_OK;
+    }
+
+    portENTER_CRITICAL(&vsync_lock);
+    bool reached = (int32_t)(vsync_count - count) >= 0;
+    bool given = vsync_waiter != xTaskGetCurrentTaskHandle();
+    if (!given) {
+        vsync_waiter = NULL;
+    }
+    portEXIT_CRITICAL(&vsync_lock);
+    if (given) {
+        /* The ISR already took us off and gives right after; consume it so the next wait starts clean */
+        xSemaphoreTake(vsync_sem, portMAX_DELAY);
+    }
+    return reached ? ESP_OK : ESP_ERR_TIMEOUT;
+}
+
 esp_err_t bsp_lcd_set_backlight(bool en)
 {
     const board_res_desc_t *brd = bsp_board_get_description();
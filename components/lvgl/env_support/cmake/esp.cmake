@@ -1,5 +1,10 @@
 file(GLOB_RECURSE SOURCES ${LVGL_ROOT_DIR}/src/*.c)
 
+if(CONFIG_LV_USE_DEMO_BENCHMARK)
+  file(GLOB_RECURSE DEMO_BENCHMARK_SOURCES ${LVGL_ROOT_DIR}/demos/benchmark/*.c)
+  list(APPEND SOURCES ${DEMO_BENCHMARK_SOURCES})
+endif()
+
 idf_build_get_property(LV_MICROPYTHON LV_MICROPYTHON)
 
 if(LV_MICROPYTHON)
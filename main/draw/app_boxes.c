@@ -10,6 +10,7 @@
  */
 
 #include "app_boxes.h"
+#include "lv_port.h"
 #include "freertos/FreeRTOS.h"
 #include "freertos/task.h"
 static const char* TAG = "app_boxes";
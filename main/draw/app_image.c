@@ -1,54 +1,48 @@
 #include "app_image.h"
+#include "pixel_ops.h"
+#include "esp_heap_caps.h"
+#include "extra/libs/sjpg/tjpgd.h"
 #include "mbedtls/base64.h"
 #include <cJSON.h>
 static const char* TAG = "app_image";
 
 #define SEE_DECODEDE_LOG 0
 
-#define IMG_WIDTH CANVAS_WIDTH
-#define IMG_HEIGHT CANVAS_HEIGHT
+#if !LV_USE_SJPG
+#error "update_canvas_with_image() needs tjpgd from LV_USE_SJPG"
+#endif
+
+#define JPEG_WORKBUF_SIZE (4096) // 与 lv_sjpg.c 的 TJPGD_WORKBUFF_SIZE 相同
+#define JPEG_MAX_SCALE (3)        // tjpgd 最多缩小到 1/8
 
-#if IMG_WIDTH != IMG_HEIGHT
-#error "IMG_WIDTH must be equal to IMG_HEIGHT"
-#elif IMG_WIDTH == 240
-#define DECODED_IMAGE_MAX_SIZE (15 * 1024)
-#elif IMG_WIDTH == 480
-#define DECODED_IMAGE_MAX_SIZE (25 * 1024)
+#if !JD_USE_SCALE
+#error "decode_jpeg_to_buffer() needs JD_USE_SCALE in tjpgdcnf.h"
 #endif
 
-static lv_img_dsc_t img_dsc = {
-    .header.always_zero = 0,
-    .header.w = IMG_WIDTH,
-    .header.h = IMG_HEIGHT,
-    .data_size = 0,
-    .header.cf = LV_IMG_CF_TRUE_COLOR,
-    .data = NULL,
-};
+typedef struct {
+    const uint8_t* data;
+    size_t size;
+    size_t pos;
+    lv_color_t* dst; // 画布缓冲区, LV_IMG_CF_TRUE_COLOR
+    lv_coord_t dst_w;
+    lv_coord_t dst_h;
+} jpeg_io_t;
 
-static lv_draw_img_dsc_t draw_dsc; // 必须 static 或全局变量
+static JDEC jpeg_dec;
+static uint8_t* jpeg_workbuf; // 放在内部 RAM, tjpgd 的 IDCT 和 MCU 缓冲区都在这里
 
-size_t decode_base64_image(const unsigned char* p_data, unsigned char* decoded_str) {
+size_t decode_base64_image(const unsigned char* p_data, unsigned char* decoded_str, size_t decoded_size) {
     if (!p_data || !decoded_str)
         return 0;
 
     size_t str_len = strlen((const char*)p_data);
     size_t output_len = 0;
-    // 获取解码后的长度
-    int decode_ret = mbedtls_base64_decode(NULL, 0, &output_len, p_data, str_len);
-    if (decode_ret == MBEDTLS_ERR_BASE64_INVALID_CHARACTER) {
-        ESP_LOGE(TAG, "Invalid character in Base64 string");
-        return 0;
-    }
-
-    // 检查解码后的长度是否合理
-    if (output_len == 0 || output_len > DECODED_IMAGE_MAX_SIZE) {
-        ESP_LOGE(TAG, "Base64 decode output size is too large or zero.");
+    // 直接解码到调用者的缓冲区，长度不够时 mbedtls 会返回 BUFFER_TOO_SMALL
+    int decode_ret = mbedtls_base64_decode(decoded_str, decoded_size, &output_len, p_data, str_len);
+    if (decode_ret == MBEDTLS_ERR_BASE64_BUFFER_TOO_SMALL) {
+        ESP_LOGE(TAG, "Base64 decode output size is too large: %zu", output_len);
         return 0;
-    }
-
-    // 实际解码操作
-    decode_ret = mbedtls_base64_decode(decoded_str, DECODED_IMAGE_MAX_SIZE, &output_len, p_data, str_len);
-    if (decode_ret != 0) {
+    } else if (decode_ret != 0) {
         ESP_LOGE(TAG, "Failed to decode Base64 string, error: %d", decode_ret);
         return 0;
     }
@@ -61,25 +55,129 @@ size_t decode_base64_image(const unsigned char* p_data, unsigned char* decoded_s
 
 
 
+static size_t jpeg_input(JDEC* jd, uint8_t* buf, size_t len) {
+    jpeg_io_t* io = (jpeg_io_t*)jd->device;
+    size_t remain = io->size - io->pos;
+    if (len > remain) {
+        len = remain;
+    }
+    if (buf) {
+        memcpy(buf, io->data + io->pos, len);
+    }
+    io->pos += len;
+    return len;
+}
+
+/* tjpgd 每解出一个 MCU 调用一次, 直接转换成 RGB565 写进画布 */
+static int jpeg_output(JDEC* jd, void* bitmap, JRECT* rect) {
+    jpeg_io_t* io = (jpeg_io_t*)jd->device;
+    const uint8_t* src = (const uint8_t*)bitmap; // JD_FORMAT 0: RGB888
+    int w = rect->right - rect->left + 1;
+    int copy_w = LV_MIN(w, io->dst_w - rect->left);
+
+    for (int y = rect->top; y <= rect->bottom; y++, src += w * 3) {
+        if (y >= io->dst_h || copy_w <= 0) {
+            break;
+        }
+        pixel_rgb888_to_color(io->dst + y * io->dst_w + rect->left, src, copy_w);
+    }
+    return 1;
+}
+
 /**
- * @brief 更新画布对象的数据
+ * @brief 把 JPEG 解码到一块 LV_IMG_CF_TRUE_COLOR 缓冲区, 不访问任何 LVGL 对象
+ * @note  不需要 lv_port_sem, 但解码器状态是静态的, 同一时间只能有一个任务调用
  *
- * @param canvas 画布对象
- * @param image_data 图像数据
+ * @param image_data JPEG 数据
+ * @param image_size JPEG 长度
+ * @param dst 目标缓冲区
+ * @param dst_w 目标宽度
+ * @param dst_h 目标高度
+ * @param area 输出, 图像覆盖的区域 (相对 dst 左上角), 其余部分填成 IMAGE_BG_COLOR; 可以为 NULL
+ * @param scale 输出, 图像缩小为 1/2^scale 放进 dst, 超出 1/8 的部分被裁掉; 可以为 NULL
+ * @return true 解码成功
+ */
+bool decode_jpeg_to_buffer(const unsigned char* image_data, size_t image_size, lv_color_t* dst, lv_coord_t dst_w,
+                           lv_coord_t dst_h, lv_area_t* area, uint8_t* scale) {
+    if (!image_data || image_size == 0 || !dst || !jpeg_workbuf)
+        return false;
+
+    jpeg_io_t io = {
+        .data = image_data,
+        .size = image_size,
+        .pos = 0,
+        .dst = dst,
+        .dst_w = dst_w,
+        .dst_h = dst_h,
+    };
+
+    uint8_t s = 0;
+    JRESULT rc = jd_prepare(&jpeg_dec, jpeg_input, jpeg_workbuf, JPEG_WORKBUF_SIZE, &io);
+    if (rc == JDR_OK) {
+        while (s < JPEG_MAX_SCALE && ((jpeg_dec.width >> s) > dst_w || (jpeg_dec.height >> s) > dst_h)) {
+            s++;
+        }
+        rc = jd_decomp(&jpeg_dec, jpeg_output, s);
+    }
+    if (rc != JDR_OK) {
+        ESP_LOGE(TAG, "Failed to decode JPEG, error: %d", rc);
+        return false;
+    }
+
+    // 比 dst 小的图像只覆盖左上角, 其余部分清成底色: 画布缓冲区轮换使用,
+    // 不清的话之前的图像和画在那里的框会一直留在缓冲区里
+    lv_coord_t w = LV_MIN(jpeg_dec.width >> s, dst_w);
+    lv_coord_t h = LV_MIN(jpeg_dec.height >> s, dst_h);
+    if (w < dst_w) {
+        for (lv_coord_t y = 0; y < h; y++) {
+            lv_color_fill(dst + y * dst_w + w, IMAGE_BG_COLOR, dst_w - w);
+        }
+    }
+    if (h < dst_h) {
+        lv_color_fill(dst + h * dst_w, IMAGE_BG_COLOR, (uint32_t)dst_w * (dst_h - h));
+    }
+
+    if (area) {
+        area->x1 = 0;
+        area->y1 = 0;
+        area->x2 = w - 1;
+        area->y2 = h - 1;
+    }
+    if (scale) {
+        *scale = s;
+    }
+    return true;
+}
+
+/**
+ * @brief 把 JPEG 直接解码到画布的缓冲区
+ * @note  不经过 LVGL 的 SJPG 解码器: 没有整帧的 RGB888 缓存, 也没有逐行回调和混合,
+ *        只刷新图像覆盖的区域
+ *
+ * @param canvas 画布对象, LV_IMG_CF_TRUE_COLOR
+ * @param image_data JPEG 数据
+ * @param image_size JPEG 长度
  */
 void update_canvas_with_image(lv_obj_t* canvas, const unsigned char* image_data, size_t image_size) {
-    if (!canvas || !image_data || image_size == 0)
+    if (!canvas)
         return;
 
-    img_dsc.data = image_data;
-    img_dsc.data_size = image_size;
-    // check if now can update image
+    lv_img_dsc_t* canvas_dsc = lv_canvas_get_img(canvas);
+    lv_area_t area;
+    if (!decode_jpeg_to_buffer(image_data, image_size, (lv_color_t*)canvas_dsc->data, canvas_dsc->header.w,
+                               canvas_dsc->header.h, &area, NULL)) {
+        return;
+    }
 
-    lv_canvas_draw_img(canvas, 0, 0, &img_dsc, &draw_dsc);
+    lv_area_move(&area, canvas->coords.x1, canvas->coords.y1);
+    lv_obj_invalidate_area(canvas, &area);
 }
 
 void init_image(void) {
-    lv_draw_img_dsc_init(&draw_dsc);
+    jpeg_workbuf = (uint8_t*)heap_caps_malloc(JPEG_WORKBUF_SIZE, MALLOC_CAP_INTERNAL | MALLOC_CAP_8BIT);
+    if (jpeg_workbuf == NULL) {
+        ESP_LOGE(TAG, "Failed to allocate JPEG work buffer");
+    }
 }
 
 ////////////////////////
@@ -20,14 +20,24 @@ extern "C" {
 #include "lvgl.h"
 #include <cJSON.h>
 
+// 界面上画布的大小; 更大的图像在解码时按 1/2, 1/4, 1/8 缩小
 #define CANVAS_WIDTH 240
 #define CANVAS_HEIGHT CANVAS_WIDTH
 
+// 一张 JPEG 的缓冲区大小, 按每像素约 2 bit 估算, 分辨率由 rp2040_image 协商
+#define IMAGE_JPEG_MAX_SIZE(w, h) ((size_t)(w) * (h) / 4 + 1024)
+#define DECODED_IMAGE_MAX_SIZE IMAGE_JPEG_MAX_SIZE(CANVAS_WIDTH, CANVAS_HEIGHT)
+
+// 画布上图像没有覆盖的部分, 与 main.c 中左侧画布的初始底色相同
+#define IMAGE_BG_COLOR lv_color_black()
+
 // 从JSON解析并显示图像的函数
 void init_image(void);
 void display_image_from_json(cJSON* json, lv_obj_t* canvas);
 
-size_t decode_base64_image(const unsigned char* p_data, unsigned char* decoded_str);
+size_t decode_base64_image(const unsigned char* p_data, unsigned char* decoded_str, size_t decoded_size);
+bool decode_jpeg_to_buffer(const unsigned char* image_data, size_t image_size, lv_color_t* dst, lv_coord_t dst_w,
+                           lv_coord_t dst_h, lv_area_t* area, uint8_t* scale);
 void update_canvas_with_image(lv_obj_t* canvas, const unsigned char* image_data, size_t image_size);
 // void update_canvas_with_image(lv_obj_t* canvas, const unsigned char* image_data, size_t image_size);
 // void display_one_image(lv_obj_t* image, const unsigned char* p_data);
@@ -1,9 +1,9 @@
 #include "esp_log.h"
 #include "lvgl.h"
-#include "cJSON.h"
 #include <stdbool.h>
 #include <stdint.h>
 #include <stddef.h>
+#include <stdlib.h>
 #include "app_keypoints.h"
 #include "esp_log.h"
 
@@ -66,109 +66,6 @@ static const skeleton_conn_t SKELETON_CONNECTIONS[] = {
     {5, 11,LINE_TYPE_VIRTUAL_SPINE, COLOR_BODY}, // 脖子中点 -> 臀部中点
 };
 
-//----------------------------------------------------------------
-// 内存管理函数 (Memory Management Functions)
-//----------------------------------------------------------------
-
-// 创建关键点数组
-static keypoint_t* create_keypoints_array(size_t count) {
-    return (keypoint_t*)malloc(sizeof(keypoint_t) * count);
-}
-
-// 释放单个 keypoints_t 结构体内部的 points 数组
-static void free_keypoints_internal(keypoints_t* kp) {
-    if (kp && kp->points) {
-        free(kp->points);
-        kp->points = NULL;
-    }
-}
-
-// 释放由 ParseJsonKeypoints 分配的所有内存
-void free_all_keypoints(keypoints_t* keypoints_array, size_t count) {
-    if (!keypoints_array) return;
-    for (size_t i = 0; i < count; ++i) {
-        free_keypoints_internal(&keypoints_array[i]);
-    }
-    free(keypoints_array);
-}
-
-//----------------------------------------------------------------
-// JSON 解析函数 (JSON Parsing Function)
-//----------------------------------------------------------------
-
-bool ParseJsonKeypoints(cJSON* keypoints_json, keypoints_t** keypoints_array, int* keypoints_count) {
-    if (!keypoints_json || !keypoints_array || !keypoints_count) return false;
-
-    int count = cJSON_GetArraySize(keypoints_json);
-    if (count <= 0) {
-        // ESP_LOGI(TAG, "JSON array is empty or not an array.");
-        return false;
-    }
-
-    // 使用 calloc 分配并自动清零，更安全
-    keypoints_t* kp_array = (keypoints_t*)calloc(count, sizeof(keypoints_t));
-    if (kp_array == NULL) {
-        ESP_LOGE(TAG, "Failed to allocate memory for keypoints array");
-        return false;
-    }
-
-    bool success = true;
-    for (int index = 0; index < count; index++) {
-        cJSON* keypointJson = cJSON_GetArrayItem(keypoints_json, index);
-        keypoints_t* current_keypoint = &kp_array[index];
-
-        // 1. 解析边界框 "box"
-        cJSON* boxJson = cJSON_GetObjectItem(keypointJson, "box");
-        if (cJSON_IsArray(boxJson) && cJSON_GetArraySize(boxJson) == 6) {
-            for (int i = 0; i < 6; i++) {
-                cJSON* item = cJSON_GetArrayItem(boxJson, i);
-                if (item) current_keypoint->box.boxArray[i] = item->valueint;
-            }
-        }
-
-        // 2. 解析关键点 "points"
-        cJSON* pointsJson = cJSON_GetObjectItem(keypointJson, "points");
-        if (cJSON_IsArray(pointsJson)) {
-            size_t points_count = cJSON_GetArraySize(pointsJson);
-            if (points_count > 0) {
-                current_keypoint->points = create_keypoints_array(points_count);
-                if (current_keypoint->points == NULL) {
-                    ESP_LOGE(TAG, "Failed to allocate memory for points at index %d", index);
-                    success = false;
-                    goto cleanup; // 分配失败，跳转到清理
-                }
-                current_keypoint->points_count = points_count;
-
-                for (int p_idx = 0; p_idx < points_count; p_idx++) {
-                    cJSON* point_json = cJSON_GetArrayItem(pointsJson, p_idx);
-                    if (!cJSON_IsArray(point_json)) continue;
-
-                    size_t point_dims = cJSON_GetArraySize(point_json);
-                    size_t loop_count = (point_dims > 3) ? 3 : point_dims;
-
-                    for (int i = 0; i < loop_count; i++) {
-                        cJSON* item = cJSON_GetArrayItem(point_json, i);
-                        if (item) {
-                            current_keypoint->points[p_idx].point[i] = (uint16_t)item->valueint;
-                        }
-                    }
-                }
-            }
-        }
-    }
-
-cleanup:
-    if (success) {
-        *keypoints_array = kp_array;
-        *keypoints_count = count;
-    } else {
-        free_all_keypoints(kp_array, count); // 如果失败，释放所有已分配的内存
-        *keypoints_array = NULL;
-        *keypoints_count = 0;
-    }
-    return success;
-}
-
 //----------------------------------------------------------------
 // 绘图函数 (Drawing Functions)
 //----------------------------------------------------------------
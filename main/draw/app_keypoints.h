@@ -71,18 +71,6 @@ void draw_keypoints(lv_obj_t* canvas, const keypoints_t* keypoints);
  */
 void init_keypoints_app(void);
 
-/**
- * @brief 从 cJSON 对象中解析出关键点数据
- *
- * @param keypoints_json 指向包含关键点数据的 cJSON 数组
- * @param keypoints_array 将被分配内存并填充数据的关键点数组指针
- * @param keypoints_count 解析出的关键点数量
- * @return true 解析成功
- * @return false 解析失败（例如内存不足或格式错误）
- * @note 如果解析失败，此函数会负责清理所有已分配的内存
- */
-bool ParseJsonKeypoints(cJSON* receivedJson, keypoints_t** keypoints_array, int* keypoints_count);
-
 /**
  * @brief 在LVGL画布上绘制所有检测到的人体骨骼
  *
@@ -92,14 +80,6 @@ bool ParseJsonKeypoints(cJSON* receivedJson, keypoints_t** keypoints_array, int*
  */
 void draw_keypoints_array(lv_obj_t* canvas, const keypoints_t* keypoints, size_t count);
 
-/**
- * @brief 释放由 ParseJsonKeypoints 分配的所有内存
- *
- * @param keypoints_array 指向要释放的关键点数组的指针
- * @param count 数组中的人体数量
- */
-void free_all_keypoints(keypoints_t* keypoints_array, size_t count);
-
 
 
 #ifdef __cplusplus
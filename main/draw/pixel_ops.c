@@ -0,0 +1,37 @@
+/**
+ * @file pixel_ops.c
+ * @date  16 October 2026
+
+ * @author Spencer Yan
+ *
+ * @note Canvas fill and RGB888 conversion used on the image path
+ *
+ * @copyright © 2026, Seeed Studio
+ */
+
+#include "pixel_ops.h"
+
+void pixel_rgb888_to_color(lv_color_t* dst, const uint8_t* src, int32_t n) {
+#if LV_COLOR_DEPTH == 16 && LV_COLOR_16_SWAP == 0
+    // 与 LV_COLOR_MAKE16() 相同, 省掉位域的读改写
+    uint16_t* d = (uint16_t*)dst;
+    for (int32_t i = 0; i < n; i++, src += 3) {
+        d[i] = (uint16_t)(((src[0] & 0xF8) << 8) | ((src[1] & 0xFC) << 3) | (src[2] >> 3));
+    }
+#else
+    for (int32_t i = 0; i < n; i++, src += 3) {
+        dst[i] = lv_color_make(src[0], src[1], src[2]);
+    }
+#endif
+}
+
+/* lv_canvas_fill_bg() 按像素走一遍绘制流程, 不透明的整块画布直接填缓冲区 */
+void pixel_canvas_fill(lv_obj_t* canvas, lv_color_t color) {
+    lv_img_dsc_t* dsc = lv_canvas_get_img(canvas);
+    if (dsc->header.cf != LV_IMG_CF_TRUE_COLOR) {
+        lv_canvas_fill_bg(canvas, color, LV_OPA_COVER);
+        return;
+    }
+    lv_color_fill((lv_color_t*)dsc->data, color, (uint32_t)dsc->header.w * dsc->header.h);
+    lv_obj_invalidate(canvas);
+}
@@ -0,0 +1,43 @@
+/**
+ * @file pixel_ops.h
+ * @date  16 October 2026
+
+ * @author Spencer Yan
+ *
+ * @note Canvas fill and RGB888 conversion used on the image path
+ *
+ * @copyright © 2026, Seeed Studio
+ */
+
+#ifndef PIXEL_OPS_H
+#define PIXEL_OPS_H
+
+#include <stdint.h>
+
+#include "lvgl.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * 结果与 lv_color_make() / lv_canvas_fill_bg() 逐位相同, 换实现时须保持:
+ * tools/pixel_test 在主机上逐个比较, tools/replay 逐帧比较 CRC.
+ */
+
+/**
+ * @brief tjpgd 输出的 RGB888 转换成 lv_color_t, 与 lv_color_make() 相同
+ */
+void pixel_rgb888_to_color(lv_color_t* dst, const uint8_t* src, int32_t n);
+
+/**
+ * @brief 整块画布填成 color 并重绘, 代替 lv_canvas_fill_bg(canvas, color, LV_OPA_COVER)
+ * @note  画布须是 LV_IMG_CF_TRUE_COLOR, 需要 lv_port_sem
+ */
+void pixel_canvas_fill(lv_obj_t* canvas, lv_color_t color);
+
+#ifdef __cplusplus
+} /*extern "C"*/
+#endif
+
+#endif /*PIXEL_OPS_H*/
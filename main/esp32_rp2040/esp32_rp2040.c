@@ -10,12 +10,22 @@
  */
 // #include "nvs.h"
 #include "time.h"
+#include <stdlib.h>
+#include <string.h>
 // #include <stdlib.h>
 #include "../main.h"
 #include "cJSON.h"
 #include "cobs.h"
 #include "driver/uart.h"
 #include "esp32_rp2040.h"
+#include "esp_console.h"
+#include "esp_event.h"
+#include "esp_timer.h"
+#include "freertos/semphr.h"
+#include "frame_proto.h"
+#include "rp2040_cmd.h"
+#include "rp2040_image.h"
+#include "rp2040_rx.h"
 static const char* TAG = "esp32_rp2040";
 
 #define ESP32_RP2040_TXD (19)
@@ -23,101 +33,444 @@ static const char* TAG = "esp32_rp2040";
 #define ESP32_RP2040_RTS (UART_PIN_NO_CHANGE)
 #define ESP32_RP2040_CTS (UART_PIN_NO_CHANGE)
 
+// 板子上连了 RTS/CTS 时打开硬件流控
+#if ESP32_RP2040_RTS != UART_PIN_NO_CHANGE && ESP32_RP2040_CTS != UART_PIN_NO_CHANGE
+#define ESP32_RP2040_FLOW_CTRL UART_HW_FLOWCTRL_CTS_RTS
+#else
+#define ESP32_RP2040_FLOW_CTRL UART_HW_FLOWCTRL_DISABLE
+#endif
+#define UART_RX_FLOW_CTRL_THRESH (100)
+
 #define ESP32_COMM_PORT_NUM (2)
-#define ESP32_COMM_BAUD_RATE (921600)
+#define ESP32_COMM_BAUD_RATE (921600) // 上电和回退时的速率, 两侧固定
 #define ESP32_RP2040_COMM_TASK_STACK_SIZE (15 * 1024)
 
 #define UART_BUF_SIZE (20 * 1024)
-#define UART_WAITING_SIZE (UART_BUF_SIZE * 2)
-#define JSON_OBJECT_POOL_SIZE (20)
-#define MAX_JSON_BUFFER_SIZE (8 * 1024)
+#define UART_READ_CHUNK (4 * 1024)
+#define UART_EVENT_QUEUE_SIZE (32)
+#define UART_RX_FULL_THRESH (96)   // RX FIFO 128 字节
+#define UART_RX_TOUT (3)           // 空闲 3 个字符时间后唤醒
+#define JSON_QUEUE_SIZE (20)
+#define MODEL_TITLE_TIMEOUT_MS (10 * 1000) // RP2040 上电后要先连上 Grove Vision AI
 
+// 请求 RP2040 使用的帧格式, RP2040 不支持时会继续发送 JSON, 三种格式都能接收;
+// FRAME_MODE_PASSTHROUGH 省去 RP2040 上的反序列化和重新序列化, 但行比二进制帧长
+#define ESP32_RP2040_FRAME_MODE FRAME_MODE_BINARY
 
-// 定义JSON对象池
-static char jsonObjectPool[JSON_OBJECT_POOL_SIZE][MAX_JSON_BUFFER_SIZE];
-static int poolIndex = 0;
+// 请求的预览分辨率, 见 rp2040_image.h; 链路饱和时自动降低, 空闲时升回这一档
+#define ESP32_RP2040_IMAGE_OPT (0)
 
-static char* getJsonObjectFromPool() {
-    char* obj = jsonObjectPool[poolIndex];
-    poolIndex = (poolIndex + 1) % JSON_OBJECT_POOL_SIZE; // 循环使用对象池
-    return obj;
-}
+// 解析或显示跟不上时, 只显示最新的一帧
+#define ESP32_RP2040_DROP_POLICY RP2040_RX_COALESCE_LATEST
+
+/**
+ * 速率协商, 全部在接收任务中进行:
+ *
+ *   BASE --CMD_BAUD--> REQUESTED --ACK N--> PROBING --收到几条完整消息, CMD_BAUD_CONFIRM--> UP
+ *
+ * RP2040 以旧速率回复后切换; 没有等到确认时自己回到 ESP32_COMM_BAUD_RATE, 所以探测
+ * 失败时 ESP32 直接切回基础速率. UP 状态下错误太多时请求下一档速率.
+ * UP 状态下每个检查周期重发一次 CMD_BAUD_CONFIRM 作为心跳, RP2040 几秒收不到就回到基础速率:
+ * ESP32 单独复位后以基础速率启动, 或者降速请求丢失时, 两侧都能回到 ESP32_COMM_BAUD_RATE 重新协商.
+ */
+static const uint32_t link_bauds[] = {4000000, 3000000, 2000000};
+#define LINK_LEVELS (sizeof(link_bauds) / sizeof(link_bauds[0]))
+
+#define LINK_ACK_TIMEOUT_US (1000 * 1000)
+#define LINK_PROBE_TIMEOUT_US (1000 * 1000) // 须小于 RP2040 等确认的时间
+#define LINK_RETRY_DELAY_US (2000 * 1000)   // 等 RP2040 回到基础速率
+#define LINK_CHECK_PERIOD_US (1000 * 1000) // 也是心跳周期, 须远小于 RP2040 的 LINK_KEEPALIVE_TIMEOUT_MS
+#define LINK_PROBE_MESSAGES (3)
+#define LINK_MAX_ERRORS (3) // 探测期间, 或 UP 状态下每个检查周期
+#define LINK_MAX_RETRIES (3)
+#define LINK_POLL_MS (100)
+
+typedef enum {
+    LINK_BASE,
+    LINK_REQUESTED,
+    LINK_PROBING,
+    LINK_UP,
+} link_state_t;
+
+static link_state_t link_state = LINK_BASE;
+static int link_level = 0;       // 下一次尝试 link_bauds[link_level], LINK_LEVELS 表示不再尝试
+static uint32_t link_baud = ESP32_COMM_BAUD_RATE;
+static uint32_t link_rx_bytes; // 收到的总字节数, 用来估计链路负载
+static uint32_t link_target;     // REQUESTED 状态下请求的速率
+static int link_retries;
+static int64_t link_since;       // 进入当前状态的时间, BASE 状态下是下一次尝试的时间
+static uint32_t link_uart_errors; // 帧错误和校验错误
+static uint32_t link_mark_received, link_mark_errors;
 
 static void __commu_event_handler(void* handler_args, esp_event_base_t base, int32_t id, void* event_data);
 
-QueueHandle_t JsonQueue;
-static char waitingBuffer[MAX_JSON_BUFFER_SIZE];
-static int waitingBufferSize = 0;
-uint8_t rev_buf[UART_BUF_SIZE]; // 临时接收缓冲区
+static QueueHandle_t JsonQueue;
+static SemaphoreHandle_t json_queue_lock; // 从 JsonQueue 取消息都要持有, 挤掉旧消息时消费者不能同时取
+static QueueHandle_t uart_queue;
+static uint8_t rev_buf[UART_READ_CHUNK]; // 临时接收缓冲区
+
+static uint32_t link_errors(const rp2040_rx_stats_t* stats) {
+    return link_uart_errors + stats->errors;
+}
+
+static void link_mark(void) {
+    rp2040_rx_stats_t stats;
+    rp2040_rx_get_stats(&stats);
+    link_mark_received = stats.received;
+    link_mark_errors = link_errors(&stats);
+    link_since = esp_timer_get_time();
+}
+
+static void link_set_baud(uint32_t baud) {
+    uart_set_baudrate(ESP32_COMM_PORT_NUM, baud);
+    link_baud = baud;
+    ESP_LOGI(TAG, "Link baud rate %lu", (unsigned long)baud);
+}
+
+static void link_on_ack(uint32_t baud);
+
+static void link_ack_done(const rp2040_cmd_reply_t* reply, void* arg) {
+    uint32_t baud;
+    // 超时由 link_poll() 重试
+    if (reply->err == ESP_OK && reply->len >= sizeof(baud)) {
+        memcpy(&baud, reply->data, sizeof(baud));
+        link_on_ack(baud);
+    }
+}
+
+static void link_send_request(void) {
+    rp2040_cmd_send(PKT_TYPE_CMD_BAUD, &link_target, sizeof(link_target), link_ack_done, NULL,
+                    LINK_ACK_TIMEOUT_US / 1000);
+    link_since = esp_timer_get_time();
+}
+
+static void link_request(uint32_t baud) {
+    if (link_state != LINK_REQUESTED || link_target != baud) {
+        link_retries = 0;
+    }
+    link_target = baud;
+    link_state = LINK_REQUESTED;
+    link_send_request();
+}
+
+/* 回到基础速率, 过一会儿尝试下一档 */
+static void link_fall_back(void) {
+    link_set_baud(ESP32_COMM_BAUD_RATE);
+    link_state = LINK_BASE;
+    link_level++;
+    link_since = esp_timer_get_time() + LINK_RETRY_DELAY_US;
+}
+
+/* RP2040 以旧速率回复 PKT_TYPE_ACK, 之后就切换到 N */
+static void link_on_ack(uint32_t baud) {
+    if (link_state != LINK_REQUESTED || baud != link_target) {
+        return;
+    }
+    link_set_baud(baud);
+    if (baud == ESP32_COMM_BAUD_RATE) {
+        link_state = LINK_BASE;
+        link_since = esp_timer_get_time() + LINK_RETRY_DELAY_US;
+        return;
+    }
+    link_state = LINK_PROBING;
+    link_mark();
+}
+
+static void link_poll(void) {
+    rp2040_rx_stats_t stats;
+    rp2040_rx_get_stats(&stats);
+    uint32_t errors = link_errors(&stats) - link_mark_errors;
+    uint32_t received = stats.received - link_mark_received;
+    int64_t elapsed = esp_timer_get_time() - link_since;
+
+    switch (link_state) {
+    case LINK_BASE:
+        // 收到过消息说明 RP2040 已经开始推理, 能处理命令
+        if (link_level < LINK_LEVELS && elapsed >= 0 && stats.received > 0) {
+            link_request(link_bauds[link_level]);
+        }
+        break;
+    case LINK_REQUESTED:
+        if (elapsed < LINK_ACK_TIMEOUT_US) {
+            break;
+        }
+        if (++link_retries < LINK_MAX_RETRIES) {
+            link_send_request();
+        } else if (link_baud == ESP32_COMM_BAUD_RATE) {
+            // RP2040 固件不支持切换速率
+            ESP_LOGW(TAG, "No reply to baud rate request, stay at %d", ESP32_COMM_BAUD_RATE);
+            link_state = LINK_BASE;
+            link_level = LINK_LEVELS;
+        } else {
+            ESP_LOGE(TAG, "RP2040 does not answer at %lu baud", (unsigned long)link_baud);
+            link_fall_back();
+        }
+        break;
+    case LINK_PROBING:
+        if (errors > LINK_MAX_ERRORS || elapsed > LINK_PROBE_TIMEOUT_US) {
+            ESP_LOGW(TAG, "Link probe at %lu baud failed, %lu errors", (unsigned long)link_baud,
+                     (unsigned long)errors);
+            link_fall_back();
+        } else if (received >= LINK_PROBE_MESSAGES && errors == 0) {
+            __cmd_send(PKT_TYPE_CMD_BAUD_CONFIRM, &link_baud, sizeof(link_baud));
+            link_state = LINK_UP;
+            link_mark();
+        }
+        break;
+    case LINK_UP:
+        if (elapsed < LINK_CHECK_PERIOD_US) {
+            break;
+        }
+        if (errors > LINK_MAX_ERRORS) {
+            ESP_LOGW(TAG, "%lu errors at %lu baud, slow down", (unsigned long)errors, (unsigned long)link_baud);
+            link_level++;
+            link_request(link_level < LINK_LEVELS ? link_bauds[link_level] : ESP32_COMM_BAUD_RATE);
+            break;
+        }
+        __cmd_send(PKT_TYPE_CMD_BAUD_CONFIRM, &link_baud, sizeof(link_baud));
+        link_mark();
+        break;
+    }
+}
+
+static bool rx_to_queue(const rp2040_msg_t* msg) {
+    return xQueueSend(JsonQueue, msg, 0) == pdPASS;
+}
+
+static int uart_write(const void* data, size_t len) {
+    return uart_write_bytes(ESP32_COMM_PORT_NUM, data, len);
+}
+
+static void model_title_done(const rp2040_cmd_reply_t* reply, void* arg) {
+    char name[RP2040_CMD_MAX_PAYLOAD + 1];
+    if (reply->err != ESP_OK) {
+        ESP_LOGW(TAG, "No model title: %s", esp_err_to_name(reply->err));
+        return;
+    }
+    memcpy(name, reply->data, reply->len);
+    name[reply->len] = '\0';
+    ESP_LOGI(TAG, "Model: %s", name);
+    esp_event_post_to(view_event_handle, VIEW_EVENT_BASE, VIEW_EVENT_MODEL_NAME, name, reply->len + 1, 0);
+}
+
+static void frame_mode_done(const rp2040_cmd_reply_t* reply, void* arg) {
+    // 旧的 RP2040 固件不回复, 继续发送 JSON
+    if (reply->err == ESP_OK && reply->len >= 1) {
+        ESP_LOGI(TAG, "RP2040 frame mode: %d", reply->data[0]);
+    }
+}
+
+/*
+ * 只有本任务往 JsonQueue 里放消息, 消费者取消息也要持有 json_queue_lock,
+ * 所以取出再放回期间队列不会被改动, 顺序不变
+ */
+static bool rx_evict_from_queue(uint32_t types, rp2040_msg_t* out) {
+    rp2040_msg_t kept[JSON_QUEUE_SIZE];
+    int n = 0;
+    bool found = false;
+
+    xSemaphoreTake(json_queue_lock, portMAX_DELAY);
+    while (n < JSON_QUEUE_SIZE && xQueueReceive(JsonQueue, &kept[n], 0) == pdPASS) {
+        if (!found && (types & RP2040_RX_MASK(kept[n].type))) {
+            *out = kept[n];
+            found = true;
+        } else {
+            n++;
+        }
+    }
+    for (int i = 0; i < n; i++) {
+        xQueueSend(JsonQueue, &kept[i], 0);
+    }
+    xSemaphoreGive(json_queue_lock);
+    return found;
+}
+
+void esp32_rp2040_receive(rp2040_msg_t* msg) {
+    for (;;) {
+        // 等待时不持有锁; 取到锁时队首可能已被挤掉, 队列空了就接着等
+        xQueuePeek(JsonQueue, msg, portMAX_DELAY);
+        xSemaphoreTake(json_queue_lock, portMAX_DELAY);
+        bool ok = xQueueReceive(JsonQueue, msg, 0) == pdPASS;
+        xSemaphoreGive(json_queue_lock);
+        if (ok) {
+            return;
+        }
+    }
+}
+
+/* 读出驱动环形缓冲区中已有的全部数据, 不等待 */
+static void esp32_rp2040_drain(void) {
+    // 换行位置只用来唤醒, rp2040_rx 自己分行
+    while (uart_pattern_pop_pos(ESP32_COMM_PORT_NUM) != -1) {
+    }
+
+    size_t avail = 0;
+    uart_get_buffered_data_len(ESP32_COMM_PORT_NUM, &avail);
+    while (avail > 0) {
+        int len = uart_read_bytes(ESP32_COMM_PORT_NUM, rev_buf, avail < UART_READ_CHUNK ? avail : UART_READ_CHUNK, 0);
+        if (len <= 0) {
+            break;
+        }
+        rp2040_rx_feed(rev_buf, len);
+        link_rx_bytes += len;
+        avail -= len < avail ? len : avail;
+    }
+}
+
 static void esp32_rp2040_comm_task(void* arg) {
     uart_config_t uart_config = {
         .baud_rate = ESP32_COMM_BAUD_RATE,
         .data_bits = UART_DATA_8_BITS,
         .parity = UART_PARITY_DISABLE,
         .stop_bits = UART_STOP_BITS_1,
-        .flow_ctrl = UART_HW_FLOWCTRL_DISABLE,
+        .flow_ctrl = ESP32_RP2040_FLOW_CTRL,
+        .rx_flow_ctrl_thresh = UART_RX_FLOW_CTRL_THRESH,
         .source_clk = UART_SCLK_DEFAULT,
     };
     int intr_alloc_flags = 0;
 
-    ESP_ERROR_CHECK(uart_driver_install(ESP32_COMM_PORT_NUM, UART_BUF_SIZE * 2, 0, 0, NULL, intr_alloc_flags));
+    ESP_ERROR_CHECK(uart_driver_install(ESP32_COMM_PORT_NUM, UART_BUF_SIZE * 2, 0, UART_EVENT_QUEUE_SIZE, &uart_queue,
+                                        intr_alloc_flags));
     ESP_ERROR_CHECK(uart_param_config(ESP32_COMM_PORT_NUM, &uart_config));
     ESP_ERROR_CHECK(
         uart_set_pin(ESP32_COMM_PORT_NUM, ESP32_RP2040_TXD, ESP32_RP2040_RXD, ESP32_RP2040_RTS, ESP32_RP2040_CTS));
-    
+
+    // JSON 行在换行处立即唤醒; 二进制帧和行的中段由 FIFO 阈值和接收超时唤醒
+    ESP_ERROR_CHECK(uart_enable_pattern_det_baud_intr(ESP32_COMM_PORT_NUM, '\n', 1, 9, 0, 0));
+    ESP_ERROR_CHECK(uart_pattern_queue_reset(ESP32_COMM_PORT_NUM, UART_EVENT_QUEUE_SIZE));
+    ESP_ERROR_CHECK(uart_set_rx_full_threshold(ESP32_COMM_PORT_NUM, UART_RX_FULL_THRESH));
+    ESP_ERROR_CHECK(uart_set_rx_timeout(ESP32_COMM_PORT_NUM, UART_RX_TOUT));
+
     vTaskDelay(50 / portTICK_PERIOD_MS);
-    __cmd_send(PKT_TYPE_CMD_MODEL_TITLE, NULL, 0);
-    
+    rp2040_cmd_send(PKT_TYPE_CMD_MODEL_TITLE, NULL, 0, model_title_done, NULL, MODEL_TITLE_TIMEOUT_MS);
+    uint8_t frame_mode[2] = {ESP32_RP2040_FRAME_MODE, FRAME_PROTO_VERSION};
+    rp2040_cmd_send(PKT_TYPE_CMD_FRAME_MODE, frame_mode, sizeof(frame_mode), frame_mode_done, NULL,
+                    MODEL_TITLE_TIMEOUT_MS);
+    rp2040_image_init(ESP32_RP2040_IMAGE_OPT);
+
+    uart_event_t event;
     while (1) {
-        int len = uart_read_bytes(ESP32_COMM_PORT_NUM, rev_buf, (UART_BUF_SIZE - 1), 10 / portTICK_PERIOD_MS);
-        if (len > 0) {
-            // check if the buffer is full
-            if (waitingBufferSize + len < MAX_JSON_BUFFER_SIZE) {
-                memcpy(waitingBuffer + waitingBufferSize, rev_buf, len);
-                waitingBufferSize += len;
-                waitingBuffer[waitingBufferSize] = '\0';
-            } else {
-                ESP_LOGE(TAG, "Waiting buffer overflow, reset.");
-                waitingBufferSize = 0;
-                continue;
-            }
-            // Attempts to extract and process all the complete JSON objects
-            char* start_ptr = waitingBuffer;
-            char* end_ptr;
-            while ((end_ptr = strchr(start_ptr, '\n')) != NULL) { // Use line breaks as end markers
-                int json_len = end_ptr - start_ptr;
-
-                if (json_len > 0 && json_len < MAX_JSON_BUFFER_SIZE) {
-                    char* jsonObject = getJsonObjectFromPool();
-                    memcpy(jsonObject, start_ptr, json_len);
-                    jsonObject[json_len] = '\0';
-
-                    // Directly send object pointers to the queue to avoid duplication
-                    if (xQueueSend(JsonQueue, &jsonObject, 0) != pdPASS) {
-                        ESP_LOGE(TAG, "Failed to send JSON object to queue.");
-                    }
-                }
-
-                start_ptr = end_ptr + 1; // Move to the start position of the next message
-            }
-
-            // Move the remaining data to the beginning of the buffer
-            waitingBufferSize = strlen(start_ptr);
-            memmove(waitingBuffer, start_ptr, waitingBufferSize + 1); // Including the ending null character
+        // 超时只用来推进速率协商和命令超时, 数据由 UART 事件唤醒
+        if (xQueueReceive(uart_queue, &event, LINK_POLL_MS / portTICK_PERIOD_MS) != pdTRUE) {
+            link_poll();
+            rp2040_cmd_poll();
+            rp2040_image_poll(link_rx_bytes, link_baud);
+            continue;
+        }
+        switch (event.type) {
+        case UART_DATA:
+        case UART_PATTERN_DET:
+            esp32_rp2040_drain();
+            break;
+        case UART_FIFO_OVF:
+        case UART_BUFFER_FULL:
+            // 已经丢了数据, 清空后从下一条消息开始重新同步
+            ESP_LOGW(TAG, "UART rx overflow (%d), resync", event.type);
+            uart_flush_input(ESP32_COMM_PORT_NUM);
+            xQueueReset(uart_queue);
+            rp2040_rx_reset();
+            break;
+        case UART_FRAME_ERR:
+        case UART_PARITY_ERR:
+            link_uart_errors++;
+            break;
+        default:
+            break;
+        }
+        link_poll();
+        rp2040_cmd_poll();
+        rp2040_image_poll(link_rx_bytes, link_baud);
+    }
+}
+
+static void console_done(const rp2040_cmd_reply_t* reply, void* arg) {
+    if (reply->err != ESP_OK) {
+        printf("%s: %s (status %d)\n", (const char*)arg, esp_err_to_name(reply->err), reply->status);
+    } else if (reply->len > 0) {
+        printf("%s: %.*s\n", (const char*)arg, (int)reply->len, (const char*)reply->data);
+    } else {
+        printf("%s: ok\n", (const char*)arg);
+    }
+}
+
+/* rp2040 model|tscore|tiou|sensor N, rp2040 title, rp2040 beep [ms] */
+static int console_cmd(int argc, char** argv) {
+    static const struct {
+        const char* name;
+        uint8_t type;
+    } params[] = {
+        {"model", PKT_TYPE_CMD_MODEL},
+        {"tscore", PKT_TYPE_CMD_TSCORE},
+        {"tiou", PKT_TYPE_CMD_TIOU},
+    };
+
+    if (argc < 2) {
+        printf("usage: rp2040 <model|tscore|tiou|sensor> <n> | title | beep [ms]\n");
+        return 1;
+    }
+    for (size_t i = 0; i < sizeof(params) / sizeof(params[0]); i++) {
+        if (strcmp(argv[1], params[i].name) == 0 && argc > 2) {
+            uint8_t value = (uint8_t)atoi(argv[2]);
+            rp2040_cmd_send(params[i].type, &value, sizeof(value), console_done, (void*)params[i].name,
+                            MODEL_TITLE_TIMEOUT_MS);
+            return 0;
+        }
+    }
+    if (strcmp(argv[1], "sensor") == 0 && argc > 2) {
+        // 由 rp2040_image 发出, 之后的自动调节不超过这一档
+        esp_err_t err = rp2040_image_request((uint8_t)atoi(argv[2]));
+        if (err == ESP_ERR_NOT_SUPPORTED) {
+            printf("sensor: too large for the RP2040 buffers, 0..%d\n", rp2040_image_opt_limit() - 1);
+            return 1;
         }
+        if (err != ESP_OK) {
+            printf("sensor: 0..%d\n", RP2040_IMAGE_OPT_COUNT - 1);
+            return 1;
+        }
+        return 0;
+    }
+    if (strcmp(argv[1], "title") == 0) {
+        rp2040_cmd_send(PKT_TYPE_CMD_MODEL_TITLE, NULL, 0, console_done, "title", MODEL_TITLE_TIMEOUT_MS);
+        return 0;
     }
+    if (strcmp(argv[1], "beep") == 0) {
+        uint32_t ms = argc > 2 ? strtoul(argv[2], NULL, 10) : 100;
+        rp2040_cmd_send(PKT_TYPE_CMD_BEEP_ON, &ms, sizeof(ms), console_done, "beep", RP2040_CMD_DEFAULT_TIMEOUT_MS);
+        return 0;
+    }
+    printf("unknown: %s\n", argv[1]);
+    return 1;
 }
 
-uint8_t JsonQueueBuffer[JSON_OBJECT_POOL_SIZE * sizeof(char*)];
+static void console_register(void) {
+    const esp_console_cmd_t cmd = {
+        .command = "rp2040",
+        .help = "Send a command to the RP2040 and print its reply",
+        .hint = "<model|tscore|tiou|sensor> <n> | title | beep [ms]",
+        .func = console_cmd,
+    };
+    // 没有控制台时忽略
+    esp_console_cmd_register(&cmd);
+}
+
+uint8_t JsonQueueBuffer[JSON_QUEUE_SIZE * sizeof(rp2040_msg_t)];
 StaticQueue_t JsonQueueBufferStruct;
 
 void esp32_rp2040_init(void) {
-    JsonQueue = xQueueCreateStatic(JSON_OBJECT_POOL_SIZE, sizeof(char*), JsonQueueBuffer, &JsonQueueBufferStruct);
-    if (JsonQueue == NULL) {
+    JsonQueue = xQueueCreateStatic(JSON_QUEUE_SIZE, sizeof(rp2040_msg_t), JsonQueueBuffer, &JsonQueueBufferStruct);
+    json_queue_lock = xSemaphoreCreateMutex();
+    if (JsonQueue == NULL || json_queue_lock == NULL) {
         ESP_LOGE(TAG, "Queue create failed");
         return;
     }
 
+    if (rp2040_rx_init(rx_to_queue, rx_evict_from_queue, ESP32_RP2040_DROP_POLICY) != ESP_OK) {
+        return;
+    }
+    rp2040_cmd_init(uart_write);
+    rp2040_rx_set_ctrl_handler(rp2040_cmd_on_packet);
+    console_register();
+
     xTaskCreatePinnedToCore(esp32_rp2040_comm_task,            // 任务函数
                             "esp32_task",                      // 任务名称
                             ESP32_RP2040_COMM_TASK_STACK_SIZE, // 堆栈大小
@@ -129,32 +482,5 @@ void esp32_rp2040_init(void) {
 }
 
 int __cmd_send(uint8_t cmd, void* p_data, uint8_t len) {
-    uint8_t buf[32] = {0};
-    uint8_t data[32] = {0};
-
-    if (len > 31) {
-        return -1;
-    }
-
-    uint8_t index = 1;
-
-    data[0] = cmd;
-
-    if (len > 0 && p_data != NULL) {
-        memcpy(&data[1], p_data, len);
-        index += len;
-    }
-    cobs_encode_result ret = cobs_encode(buf, sizeof(buf), data, index);
-#if 0 // SENSOR_COMM_DEBUG
-    ESP_LOGI(TAG, "encode status:%d, len:%d", ret.status, ret.out_len);
-    for (int i = 0; i < ret.out_len; i++) {
-        printf("0x%x ", buf[i]);
-    }
-    printf("\r\n");
-#endif
-
-    if (ret.status == COBS_ENCODE_OK) {
-        return uart_write_bytes(ESP32_COMM_PORT_NUM, buf, ret.out_len + 1);
-    }
-    return -1;
-}
\ No newline at end of file
+    return rp2040_cmd_send(cmd, p_data, len, NULL, NULL, 0) == ESP_OK ? 0 : -1;
+}
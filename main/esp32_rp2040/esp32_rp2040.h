@@ -24,6 +24,15 @@ enum  pkt_type {
     PKT_TYPE_CMD_SHUTDOWN = 0xA3, //uin32_t 
     PKT_TYPE_CMD_POWER_ON = 0xA4,
     PKT_TYPE_CMD_MODEL_TITLE = 0xA5,
+    PKT_TYPE_CMD_FRAME_MODE = 0xA6, //uint8_t mode, uint8_t version: see frame_proto.h
+    PKT_TYPE_CMD_BAUD = 0xA7,         //uint32_t baud, little endian: RP2040 acks at the old rate and switches
+    PKT_TYPE_CMD_BAUD_CONFIRM = 0xA8, //uint32_t baud: link works at N, RP2040 keeps it
+    PKT_TYPE_CMD_MODEL = 0xA9,        //uint8_t model id: AT+MODEL
+    PKT_TYPE_CMD_TSCORE = 0xAA,       //uint8_t score threshold 0-100: AT+TSCORE
+    PKT_TYPE_CMD_TIOU = 0xAB,         //uint8_t IoU threshold 0-100: AT+TIOU
+    PKT_TYPE_CMD_SENSOR = 0xAC,       //uint8_t opt_id: AT+SENSOR, replies uint16_t width, height; see rp2040_image.h
+
+    PKT_TYPE_ACK = 0xC0, // RP2040 -> ESP32: uint8_t status, reply data; see rp2040_cmd.h
 
     // PKT_TYPE_SENSOR_SCD41_TEMP  = 0xB0, // float
     // PKT_TYPE_SENSOR_SCD41_HUMIDITY = 0xB1, // float
@@ -37,7 +46,30 @@ enum  pkt_type {
     //todo
 };
 
+typedef enum {
+    RP2040_MSG_JSON,      // data: 以 '\0' 结尾的 JSON 行
+    RP2040_MSG_BIN_FRAME, // data: 已校验的二进制帧, 见 frame_proto.h
+    RP2040_MSG_IMAGE,     // data: frame_buf_t*, 接收方负责 frame_buf_unref()
+} rp2040_msg_type_t;
+
+/* JsonQueue 中的元素 */
+typedef struct {
+    rp2040_msg_type_t type;
+    void* data;
+    int64_t t_rx; // esp_timer_get_time(), 这一行或这一帧接收完成的时间
+} rp2040_msg_t;
+
 void esp32_rp2040_init(void);
+
+/**
+ * @brief 从 JsonQueue 取出下一条消息, 没有时一直等待
+ * @note  只能有一个消费者; 下游跟不上时接收任务会从队列中挤掉旧消息, 取消息须经过这里
+ */
+void esp32_rp2040_receive(rp2040_msg_t* msg);
+
+/**
+ * @brief 发送不需要回复的命令, 需要回复时用 rp2040_cmd_send()
+ */
 int __cmd_send(uint8_t cmd, void* p_data, uint8_t len);
 
 #ifdef __cplusplus
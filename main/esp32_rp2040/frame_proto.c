@@ -0,0 +1,59 @@
+/**
+ * @file frame_proto.c
+ * @date  16 October 2026
+
+ * @author Spencer Yan
+ *
+ * @note Binary frame format sent by the RP2040 once FRAME_MODE_BINARY is negotiated
+ *
+ * @copyright © 2026, Seeed Studio
+ */
+
+#include "frame_proto.h"
+#include "esp_rom_crc.h"
+#include <string.h>
+
+size_t frame_proto_frame_size(const uint8_t* header) {
+    frame_proto_header_t hdr;
+    memcpy(&hdr, header, sizeof(hdr));
+
+    if (hdr.magic[0] != FRAME_PROTO_MAGIC0 || hdr.magic[1] != FRAME_PROTO_MAGIC1) {
+        return 0;
+    }
+    if (hdr.version != FRAME_PROTO_VERSION || hdr.payload_len > FRAME_PROTO_MAX_PAYLOAD) {
+        return 0;
+    }
+    return FRAME_PROTO_HEADER_SIZE + hdr.payload_len + FRAME_PROTO_CRC_SIZE;
+}
+
+bool frame_proto_verify(const uint8_t* frame, size_t len) {
+    if (len < FRAME_PROTO_HEADER_SIZE + FRAME_PROTO_CRC_SIZE || frame_proto_frame_size(frame) != len) {
+        return false;
+    }
+
+    uint32_t crc;
+    memcpy(&crc, frame + len - FRAME_PROTO_CRC_SIZE, sizeof(crc));
+    return esp_rom_crc32_le(0, frame, len - FRAME_PROTO_CRC_SIZE) == crc;
+}
+
+bool frame_proto_next_section(const uint8_t* frame, size_t* offset, frame_section_t* sec) {
+    frame_proto_header_t hdr;
+    frame_proto_section_t sec_hdr;
+    memcpy(&hdr, frame, sizeof(hdr));
+
+    if (*offset + sizeof(sec_hdr) > hdr.payload_len) {
+        return false;
+    }
+
+    const uint8_t* p = frame + FRAME_PROTO_HEADER_SIZE + *offset;
+    memcpy(&sec_hdr, p, sizeof(sec_hdr));
+    if (*offset + sizeof(sec_hdr) + sec_hdr.len > hdr.payload_len) {
+        return false; // truncated section
+    }
+
+    sec->type = sec_hdr.type;
+    sec->len = sec_hdr.len;
+    sec->data = p + sizeof(sec_hdr);
+    *offset += sizeof(sec_hdr) + sec_hdr.len;
+    return true;
+}
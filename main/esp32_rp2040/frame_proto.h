@@ -0,0 +1,113 @@
+/**
+ * @file frame_proto.h
+ * @date  16 October 2026
+
+ * @author Spencer Yan
+ *
+ * @note Binary frame format sent by the RP2040 once FRAME_MODE_BINARY is negotiated
+ *
+ * @copyright © 2026, Seeed Studio
+ */
+
+#ifndef FRAME_PROTO_H
+#define FRAME_PROTO_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * Frame layout (little-endian), must match 1_RP2040_Arduino/RP2040/frame_proto.h:
+ *
+ *   frame_proto_header_t | section | section | ... | crc32
+ *
+ * Each section is a frame_proto_section_t followed by `len` bytes. The CRC-32
+ * (IEEE) covers the header and the payload. JSON lines always start with '{',
+ * so FRAME_PROTO_MAGIC0 at the start of a message tells the two formats apart.
+ */
+#define FRAME_PROTO_MAGIC0 (0xAA)
+#define FRAME_PROTO_MAGIC1 (0x55)
+#define FRAME_PROTO_VERSION (1)
+
+#define FRAME_PROTO_HEADER_SIZE (sizeof(frame_proto_header_t))
+#define FRAME_PROTO_CRC_SIZE (4)
+#define FRAME_PROTO_MAX_PAYLOAD (32 * 1024)
+#define FRAME_PROTO_MAX_FRAME_SIZE (FRAME_PROTO_HEADER_SIZE + FRAME_PROTO_MAX_PAYLOAD + FRAME_PROTO_CRC_SIZE)
+
+enum frame_mode {
+    FRAME_MODE_JSON = 0,
+    FRAME_MODE_BINARY = 1,
+    FRAME_MODE_PASSTHROUGH = 2, // SSCMA INVOKE 事件的 data 原样转发, 仍是 JSON 行
+};
+
+enum frame_section_type {
+    FRAME_SEC_PERF = 0x01,      // 3 x u16: preprocess, inference, postprocess
+    FRAME_SEC_BOXES = 0x02,     // n x {u16 x, y, w, h; u8 score, target}
+    FRAME_SEC_CLASSES = 0x03,   // n x {u8 target, score}
+    FRAME_SEC_POINTS = 0x04,    // n x {u16 x, y; u8 score, target}
+    FRAME_SEC_KEYPOINTS = 0x05, // n x {box; u8 count; count x {u16 x, y; u8 score}}
+    FRAME_SEC_JPEG = 0x06,      // raw JPEG bytes
+};
+
+#define FRAME_SEC_BOX_SIZE (10)
+#define FRAME_SEC_CLASS_SIZE (2)
+#define FRAME_SEC_POINT_SIZE (6)
+#define FRAME_SEC_KEYPOINT_SIZE (5)
+
+typedef struct __attribute__((packed)) {
+    uint8_t magic[2];
+    uint8_t version;
+    uint8_t flags;
+    uint16_t seq;
+    uint16_t reserved;
+    uint32_t payload_len;
+} frame_proto_header_t;
+
+typedef struct __attribute__((packed)) {
+    uint8_t type;
+    uint8_t reserved;
+    uint16_t len;
+} frame_proto_section_t;
+
+typedef struct {
+    uint8_t type;
+    uint16_t len;
+    const uint8_t* data;
+} frame_section_t;
+
+/**
+ * @brief 根据帧头计算整帧长度（帧头 + 负载 + CRC）
+ *
+ * @param header 至少 FRAME_PROTO_HEADER_SIZE 字节
+ * @return 0 表示帧头无效
+ */
+size_t frame_proto_frame_size(const uint8_t* header);
+
+/**
+ * @brief 校验整帧的 CRC
+ */
+bool frame_proto_verify(const uint8_t* frame, size_t len);
+
+/**
+ * @brief 遍历帧中的 section
+ *
+ * @param frame 已校验的整帧
+ * @param offset 负载内的偏移，首次调用时置 0
+ * @param sec 输出的 section
+ * @return false 表示没有更多 section
+ */
+bool frame_proto_next_section(const uint8_t* frame, size_t* offset, frame_section_t* sec);
+
+static inline uint16_t frame_proto_rd16(const uint8_t* p) {
+    return (uint16_t)(p[0] | (p[1] << 8));
+}
+
+#ifdef __cplusplus
+} /*extern "C"*/
+#endif
+
+#endif /*FRAME_PROTO_H*/
@@ -0,0 +1,169 @@
+/**
+ * @file rp2040_cmd.c
+ * @date  16 October 2026
+
+ * @author Spencer Yan
+ *
+ * @note Control channel to the RP2040: COBS packets with request IDs and asynchronous replies
+ *
+ * @copyright © 2026, Seeed Studio
+ */
+
+#include "rp2040_cmd.h"
+#include <string.h>
+#include "cobs.h"
+#include "esp32_rp2040.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "freertos/FreeRTOS.h"
+
+static const char* TAG = "rp2040_cmd";
+
+#define CMD_HEADER_SIZE (2) // type, id
+#define ACK_HEADER_SIZE (3) // PKT_TYPE_ACK, id, status
+#define CMD_RAW_MAX (CMD_HEADER_SIZE + RP2040_CMD_MAX_PAYLOAD)
+
+typedef struct {
+    uint8_t id; // 0 表示空闲
+    uint8_t type;
+    rp2040_cmd_done_t done;
+    void* arg;
+    int64_t deadline;
+} cmd_pending_t;
+
+static rp2040_cmd_write_t cmd_write;
+static cmd_pending_t pending[RP2040_CMD_MAX_PENDING];
+static uint8_t next_id = 1;
+static portMUX_TYPE cmd_lock = portMUX_INITIALIZER_UNLOCKED;
+
+void rp2040_cmd_init(rp2040_cmd_write_t write) {
+    cmd_write = write;
+}
+
+/* 取一个不为 0, 也没有在等待回复的 id, 须持有 cmd_lock */
+static uint8_t cmd_alloc_id(void) {
+    for (;;) {
+        uint8_t id = next_id++;
+        if (id == 0) {
+            continue;
+        }
+        bool used = false;
+        for (int i = 0; i < RP2040_CMD_MAX_PENDING; i++) {
+            used |= pending[i].id == id;
+        }
+        if (!used) {
+            return id;
+        }
+    }
+}
+
+esp_err_t rp2040_cmd_send(uint8_t type, const void* data, size_t len, rp2040_cmd_done_t done, void* arg,
+                          uint32_t timeout_ms) {
+    uint8_t raw[CMD_RAW_MAX];
+    uint8_t buf[COBS_ENCODE_DST_BUF_LEN_MAX(CMD_RAW_MAX) + 1];
+
+    if (len > RP2040_CMD_MAX_PAYLOAD || (len > 0 && data == NULL)) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    uint8_t id = 0;
+    if (done != NULL) {
+        portENTER_CRITICAL(&cmd_lock);
+        cmd_pending_t* slot = NULL;
+        for (int i = 0; i < RP2040_CMD_MAX_PENDING && slot == NULL; i++) {
+            if (pending[i].id == 0) {
+                slot = &pending[i];
+            }
+        }
+        if (slot != NULL) {
+            id = cmd_alloc_id();
+            *slot = (cmd_pending_t){
+                .id = id,
+                .type = type,
+                .done = done,
+                .arg = arg,
+                .deadline = esp_timer_get_time() + (int64_t)timeout_ms * 1000,
+            };
+        }
+        portEXIT_CRITICAL(&cmd_lock);
+        if (slot == NULL) {
+            ESP_LOGW(TAG, "Too many pending commands, drop 0x%02x", type);
+            return ESP_ERR_NO_MEM;
+        }
+    }
+
+    raw[0] = type;
+    raw[1] = id;
+    if (len > 0) {
+        memcpy(&raw[CMD_HEADER_SIZE], data, len);
+    }
+    cobs_encode_result ret = cobs_encode(buf, sizeof(buf) - 1, raw, CMD_HEADER_SIZE + len);
+    if (ret.status != COBS_ENCODE_OK) {
+        return ESP_FAIL;
+    }
+    buf[ret.out_len] = 0x00;
+    // 没有写出去时回复不会来, 由超时完成
+    int written = cmd_write(buf, ret.out_len + 1);
+    return written == (int)(ret.out_len + 1) ? ESP_OK : ESP_FAIL;
+}
+
+/* 从表中取出 id 对应的命令 */
+static bool cmd_take(uint8_t id, cmd_pending_t* out) {
+    bool found = false;
+    portENTER_CRITICAL(&cmd_lock);
+    for (int i = 0; i < RP2040_CMD_MAX_PENDING; i++) {
+        if (id != 0 && pending[i].id == id) {
+            *out = pending[i];
+            pending[i].id = 0;
+            found = true;
+            break;
+        }
+    }
+    portEXIT_CRITICAL(&cmd_lock);
+    return found;
+}
+
+void rp2040_cmd_on_packet(const uint8_t* pkt, size_t len) {
+    if (len < ACK_HEADER_SIZE || pkt[0] != PKT_TYPE_ACK) {
+        ESP_LOGW(TAG, "Unexpected control packet 0x%02x, %d bytes", len > 0 ? pkt[0] : 0, (int)len);
+        return;
+    }
+
+    cmd_pending_t cmd;
+    if (!cmd_take(pkt[1], &cmd)) {
+        // 已经超时, 或者是链路切换前的旧回复
+        ESP_LOGD(TAG, "Reply to unknown id %d", pkt[1]);
+        return;
+    }
+
+    rp2040_cmd_reply_t reply = {
+        .err = pkt[2] == 0 ? ESP_OK : ESP_FAIL,
+        .status = pkt[2],
+        .data = pkt + ACK_HEADER_SIZE,
+        .len = len - ACK_HEADER_SIZE,
+    };
+    if (reply.err != ESP_OK) {
+        ESP_LOGW(TAG, "Command 0x%02x failed, status %d", cmd.type, reply.status);
+    }
+    cmd.done(&reply, cmd.arg);
+}
+
+void rp2040_cmd_poll(void) {
+    int64_t now = esp_timer_get_time();
+
+    for (int i = 0; i < RP2040_CMD_MAX_PENDING; i++) {
+        cmd_pending_t cmd = {0};
+        portENTER_CRITICAL(&cmd_lock);
+        if (pending[i].id != 0 && now >= pending[i].deadline) {
+            cmd = pending[i];
+            pending[i].id = 0;
+        }
+        portEXIT_CRITICAL(&cmd_lock);
+
+        if (cmd.id != 0) {
+            ESP_LOGW(TAG, "Command 0x%02x (id %d) timed out", cmd.type, cmd.id);
+            rp2040_cmd_reply_t reply = {.err = ESP_ERR_TIMEOUT};
+            cmd.done(&reply, cmd.arg);
+        }
+    }
+}
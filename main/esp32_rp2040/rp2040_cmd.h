@@ -0,0 +1,89 @@
+/**
+ * @file rp2040_cmd.h
+ * @date  16 October 2026
+
+ * @author Spencer Yan
+ *
+ * @note Control channel to the RP2040: COBS packets with request IDs and asynchronous replies
+ *
+ * @copyright © 2026, Seeed Studio
+ */
+
+#ifndef RP2040_CMD_H
+#define RP2040_CMD_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "esp_err.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * 两个通道共用一条 UART:
+ *
+ *   控制通道  COBS 编码, 以 0x00 分隔: type, id, 负载. ESP32 -> RP2040 只有这个通道;
+ *            RP2040 -> ESP32 的包前后都有 0x00, 可以插在 JSON 行的中间发送,
+ *            不用等多 KB 的图像行发完, 但不会插进二进制帧
+ *   帧通道    RP2040 -> ESP32 的 JSON 行和二进制帧, 见 rp2040_rx.h
+ *
+ * id 为 0 的命令不需要回复; 其他命令由 RP2040 回复 PKT_TYPE_ACK: id, status, 数据.
+ */
+#define RP2040_CMD_MAX_PAYLOAD (240) // RP2040 PacketSerial 的缓冲区为 256 字节
+#define RP2040_CMD_MAX_PENDING (8)
+#define RP2040_CMD_DEFAULT_TIMEOUT_MS (1000)
+
+typedef struct {
+    esp_err_t err;       // ESP_OK, ESP_FAIL (status 非 0) 或 ESP_ERR_TIMEOUT
+    uint8_t status;      // RP2040 回复的状态, 通常是 SSCMA 的 CMD_* 代码
+    const uint8_t* data; // 回复的数据, 回调返回后失效
+    size_t len;
+} rp2040_cmd_reply_t;
+
+/**
+ * @brief 命令完成时调用, 在 esp32_task 中
+ */
+typedef void (*rp2040_cmd_done_t)(const rp2040_cmd_reply_t* reply, void* arg);
+
+/**
+ * @brief 把编码好的包写到 UART
+ */
+typedef int (*rp2040_cmd_write_t)(const void* data, size_t len);
+
+/**
+ * @param write 固件中是 uart_write_bytes(), 本身是线程安全的
+ */
+void rp2040_cmd_init(rp2040_cmd_write_t write);
+
+/**
+ * @brief 发送一条命令, 不等待回复, 可以在任意任务中调用
+ *
+ * @param type enum pkt_type
+ * @param data 负载, 最多 RP2040_CMD_MAX_PAYLOAD 字节
+ * @param len 负载长度
+ * @param done 为 NULL 时不需要回复
+ * @param arg 传给 done
+ * @param timeout_ms 等待回复的时间, 超时后以 ESP_ERR_TIMEOUT 调用 done
+ * @return ESP_ERR_NO_MEM 表示等待回复的命令太多
+ */
+esp_err_t rp2040_cmd_send(uint8_t type, const void* data, size_t len, rp2040_cmd_done_t done, void* arg,
+                          uint32_t timeout_ms);
+
+/**
+ * @brief 处理 RP2040 发来的一个已解码的控制包, 在 esp32_task 中
+ */
+void rp2040_cmd_on_packet(const uint8_t* pkt, size_t len);
+
+/**
+ * @brief 让超时的命令完成, 在 esp32_task 中定期调用
+ */
+void rp2040_cmd_poll(void);
+
+#ifdef __cplusplus
+} /*extern "C"*/
+#endif
+
+#endif /*RP2040_CMD_H*/
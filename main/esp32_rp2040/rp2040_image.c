@@ -0,0 +1,174 @@
+/**
+ * @file rp2040_image.c
+ * @date  16 October 2026
+
+ * @author Spencer Yan
+ *
+ * @note Preview resolution negotiated with the RP2040/SSCMA at runtime, stepped down while the link is saturated
+ *
+ * @copyright © 2026, Seeed Studio
+ */
+
+#include "rp2040_image.h"
+#include <stdbool.h>
+#include <stdio.h>
+#include <string.h>
+#include "app_image.h"
+#include "esp32_rp2040.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "frame_pool.h"
+#include "frame_proto.h"
+#include "rp2040_cmd.h"
+
+static const char* TAG = "rp2040_image";
+
+#define OPT_UNKNOWN (0xFF)
+
+// 控制台写, esp32_task 读
+static volatile uint8_t max_opt;
+static volatile bool max_changed;
+static volatile bool max_report; // 这次请求来自控制台, 回复时打印
+
+// esp32_task 写, 控制台读
+static volatile uint8_t opt_limit = RP2040_IMAGE_OPT_COUNT;
+
+// 以下只在 esp32_task 中访问
+static uint8_t current_opt = OPT_UNKNOWN;
+static bool pending;
+static bool reporting;
+static uint8_t saturated_opt = OPT_UNKNOWN; // 最近一次因负载太高降下来的档位
+static int64_t saturated_since;
+static int low_periods;
+static int64_t window_start;
+static uint32_t window_bytes;
+
+static void image_done(const rp2040_cmd_reply_t* reply, void* arg) {
+    uint8_t opt = (uint8_t)(uintptr_t)arg;
+    uint16_t size[2];
+
+    bool report = reporting;
+
+    pending = false;
+    reporting = false;
+    if (reply->status == RP2040_IMAGE_STATUS_TOO_LARGE && reply->len >= sizeof(size) && opt > 0) {
+        // RP2040 已经退回原来的档位; 以后最高请求低一档, 宽高由那次回复给出
+        memcpy(size, reply->data, sizeof(size));
+        ESP_LOGW(TAG, "Image %ux%u (opt %d) too large for the RP2040 buffers", size[0], size[1], opt);
+        if (report) {
+            printf("sensor: %ux%u (opt %d) too large for the RP2040, using opt %d\n", size[0], size[1], opt,
+                   opt - 1);
+        }
+        opt_limit = opt;
+        if (max_opt >= opt) {
+            max_opt = opt - 1;
+        }
+        max_changed = true;
+        return;
+    }
+    if (reply->err != ESP_OK || reply->len < sizeof(size)) {
+        // 旧的 RP2040 固件不支持, 保持原来的分辨率
+        ESP_LOGW(TAG, "Sensor opt %d rejected: %s", opt, esp_err_to_name(reply->err));
+        if (report) {
+            printf("sensor: %s (status %d)\n", esp_err_to_name(reply->err), reply->status);
+        }
+        return;
+    }
+    memcpy(size, reply->data, sizeof(size));
+
+    size_t buf_size = IMAGE_JPEG_MAX_SIZE(size[0], size[1]);
+    if (buf_size > FRAME_PROTO_MAX_PAYLOAD) { // 二进制帧装不下更大的图像
+        buf_size = FRAME_PROTO_MAX_PAYLOAD;
+    }
+    if (buf_size < DECODED_IMAGE_MAX_SIZE) {
+        buf_size = DECODED_IMAGE_MAX_SIZE;
+    }
+    frame_pool_set_buf_size(buf_size);
+
+    current_opt = opt;
+    low_periods = 0;
+    window_start = 0;
+    ESP_LOGI(TAG, "Image %ux%u (opt %d), %u bytes per buffer", size[0], size[1], opt, (unsigned)buf_size);
+    if (report) {
+        printf("sensor: %ux%u (opt %d)\n", size[0], size[1], opt);
+    }
+}
+
+static void image_send(uint8_t opt) {
+    if (rp2040_cmd_send(PKT_TYPE_CMD_SENSOR, &opt, sizeof(opt), image_done, (void*)(uintptr_t)opt,
+                        RP2040_IMAGE_TIMEOUT_MS) == ESP_OK) {
+        pending = true;
+    }
+}
+
+void rp2040_image_init(uint8_t opt) {
+    max_opt = opt;
+    max_changed = true;
+}
+
+esp_err_t rp2040_image_request(uint8_t opt) {
+    if (opt >= RP2040_IMAGE_OPT_COUNT) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    if (opt >= opt_limit) {
+        return ESP_ERR_NOT_SUPPORTED;
+    }
+    max_opt = opt;
+    max_report = true;
+    max_changed = true;
+    return ESP_OK;
+}
+
+uint8_t rp2040_image_opt_limit(void) {
+    return opt_limit;
+}
+
+void rp2040_image_poll(uint32_t rx_bytes, uint32_t baud) {
+    int64_t now = esp_timer_get_time();
+
+    if (pending) {
+        return;
+    }
+    if (max_changed) {
+        max_changed = false;
+        reporting = max_report;
+        max_report = false;
+        saturated_opt = OPT_UNKNOWN;
+        image_send(max_opt);
+        return;
+    }
+    // 还没有协商成功时不调节
+    if (current_opt == OPT_UNKNOWN) {
+        return;
+    }
+
+    if (window_start == 0) {
+        window_start = now;
+        window_bytes = rx_bytes;
+        return;
+    }
+    int64_t elapsed = now - window_start;
+    if (elapsed < RP2040_IMAGE_PERIOD_US) {
+        return;
+    }
+
+    // 每字节 10 bit (8N1)
+    uint32_t load = (uint64_t)(rx_bytes - window_bytes) * 10 * 100 * 1000000 / ((uint64_t)baud * elapsed);
+    window_start = now;
+    window_bytes = rx_bytes;
+
+    if (load >= RP2040_IMAGE_HIGH_LOAD && current_opt > 0) {
+        ESP_LOGW(TAG, "Link at %lu%% of %lu baud, lower the resolution", (unsigned long)load, (unsigned long)baud);
+        saturated_opt = current_opt;
+        saturated_since = now;
+        low_periods = 0;
+        image_send(current_opt - 1);
+    } else if (load < RP2040_IMAGE_LOW_LOAD && current_opt < max_opt) {
+        bool retry = current_opt + 1 != saturated_opt || now - saturated_since > RP2040_IMAGE_RETRY_US;
+        if (retry && ++low_periods >= RP2040_IMAGE_UP_PERIODS) {
+            image_send(current_opt + 1);
+        }
+    } else {
+        low_periods = 0;
+    }
+}
@@ -0,0 +1,75 @@
+/**
+ * @file rp2040_image.h
+ * @date  16 October 2026
+
+ * @author Spencer Yan
+ *
+ * @note Preview resolution negotiated with the RP2040/SSCMA at runtime, stepped down while the link is saturated
+ *
+ * @copyright © 2026, Seeed Studio
+ */
+
+#ifndef RP2040_IMAGE_H
+#define RP2040_IMAGE_H
+
+#include <stdint.h>
+
+#include "esp_err.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * 分辨率用 SSCMA 摄像头的 opt_id 表示 (AT+SENSOR=1,1,opt), Grove Vision AI V2 上
+ * 0: 240x240, 1: 416x416, 2: 480x480, 3: 640x480, 编号越大图像越大.
+ * RP2040 回复实际的宽高, 据此调整 frame_pool 的缓冲区; 比画布大的图像在解码时缩小.
+ *
+ * SSCMA 没有设置 JPEG 质量的命令, 图像大小只能通过分辨率调节:
+ * 链路负载 (接收字节 / 波特率) 超过 RP2040_IMAGE_HIGH_LOAD 时降一档,
+ * 连续 RP2040_IMAGE_UP_PERIODS 个周期低于 RP2040_IMAGE_LOW_LOAD 时升一档, 最高到请求的档位.
+ *
+ * RP2040 的接收和发送缓冲区装不下某一档的 JPEG (按 IMAGE_JPEG_MAX_SIZE 估算) 时, 它退回原来的档位,
+ * 以 RP2040_IMAGE_STATUS_TOO_LARGE 回复; 之后最高只请求低一档, 控制台也不再接受这一档及以上.
+ */
+#define RP2040_IMAGE_OPT_COUNT (4)
+#define RP2040_IMAGE_PERIOD_US (2000 * 1000)
+#define RP2040_IMAGE_HIGH_LOAD (85) // %
+#define RP2040_IMAGE_LOW_LOAD (40)
+#define RP2040_IMAGE_UP_PERIODS (3)
+#define RP2040_IMAGE_RETRY_US (30 * 1000 * 1000) // 饱和过的档位, 这么久之后才再试
+#define RP2040_IMAGE_TIMEOUT_MS (10 * 1000)      // RP2040 上电后要先连上 Grove Vision AI
+#define RP2040_IMAGE_STATUS_TOO_LARGE (6)        // SSCMA 的 CMD_ENOMEM, 回复数据是这一档的宽高
+
+/**
+ * @brief 设置启动时请求的档位, 请求在第一次 rp2040_image_poll() 时发出
+ */
+void rp2040_image_init(uint8_t opt);
+
+/**
+ * @brief 请求新的档位, 之后自动调节不会超过它; 可以在任意任务中调用
+ * @note  RP2040 回复后在控制台打印结果
+ *
+ * @return ESP_ERR_INVALID_ARG 表示 opt 超出 RP2040_IMAGE_OPT_COUNT,
+ *         ESP_ERR_NOT_SUPPORTED 表示 RP2040 已经拒绝过这一档或更低的档位
+ */
+esp_err_t rp2040_image_request(uint8_t opt);
+
+/**
+ * @brief RP2040 能接受的档位数, 拒绝过之前是 RP2040_IMAGE_OPT_COUNT
+ */
+uint8_t rp2040_image_opt_limit(void);
+
+/**
+ * @brief 发出请求, 统计链路负载并调节档位, 在 esp32_task 中定期调用
+ *
+ * @param rx_bytes 从 RP2040 收到的总字节数, 32 位回绕
+ * @param baud 当前的链路速率
+ */
+void rp2040_image_poll(uint32_t rx_bytes, uint32_t baud);
+
+#ifdef __cplusplus
+} /*extern "C"*/
+#endif
+
+#endif /*RP2040_IMAGE_H*/
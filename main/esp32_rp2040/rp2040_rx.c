@@ -0,0 +1,462 @@
+/**
+ * @file rp2040_rx.c
+ * @date  16 October 2026
+
+ * @author Spencer Yan
+ *
+ * @note Splits the byte stream from the RP2040 into JSON lines, streamed images, binary frames and control packets
+ *
+ * @copyright © 2026, Seeed Studio
+ */
+
+#include "rp2040_rx.h"
+#include <stdatomic.h>
+#include <string.h>
+#include "b64_stream.h"
+#include "cobs.h"
+#include "esp_heap_caps.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "frame_pool.h"
+#include "frame_proto.h"
+
+static const char* TAG = "rp2040_rx";
+
+#define JSON_OBJECT_POOL_SIZE (4)
+#define MAX_JSON_BUFFER_SIZE (8 * 1024)
+#define BIN_FRAME_POOL_SIZE (4)
+#define CTRL_PACKET_MAX_SIZE (256) // 编码后, 不含分隔符
+#define RX_POOL_MAX_SIZE (4)
+
+#if JSON_OBJECT_POOL_SIZE > RX_POOL_MAX_SIZE || BIN_FRAME_POOL_SIZE > RX_POOL_MAX_SIZE
+#error "RX_POOL_MAX_SIZE is too small"
+#endif
+
+// 图像行在接收时直接解码, 不经过 waitingBuffer
+#define IMG_FIELD "\"img\":\""
+#define IMG_FIELD_LEN (sizeof(IMG_FIELD) - 1)
+
+static rp2040_rx_sink_t rx_sink;
+static rp2040_rx_evict_t rx_evict;
+static rp2040_rx_policy_t rx_policy;
+static rp2040_rx_stats_t rx_stats;
+static rp2040_rx_ctrl_t rx_ctrl;
+
+/**
+ * JSON 行和二进制帧的缓冲池, 在 PSRAM 中分配. 缓冲区随消息交给下游,
+ * 下游调用 rp2040_rx_release() 后才会被再次使用.
+ */
+typedef struct {
+    void* buf[RX_POOL_MAX_SIZE];
+    atomic_bool used[RX_POOL_MAX_SIZE];
+    int count;
+    rp2040_msg_type_t type;
+} rx_pool_t;
+
+static rx_pool_t jsonObjectPool = {.count = JSON_OBJECT_POOL_SIZE, .type = RP2040_MSG_JSON};
+static rx_pool_t binFramePool = {.count = BIN_FRAME_POOL_SIZE, .type = RP2040_MSG_BIN_FRAME};
+
+static void* rx_pool_try_get(rx_pool_t* pool) {
+    for (int i = 0; i < pool->count; i++) {
+        bool expected = false;
+        if (atomic_compare_exchange_strong(&pool->used[i], &expected, true)) {
+            return pool->buf[i];
+        }
+    }
+    return NULL;
+}
+
+static void rx_pool_put(rx_pool_t* pool, const void* buf) {
+    for (int i = 0; i < pool->count; i++) {
+        if (pool->buf[i] == buf) {
+            atomic_store(&pool->used[i], false);
+            return;
+        }
+    }
+    ESP_LOGE(TAG, "Release of unknown buffer %p", buf);
+}
+
+/* 丢掉一条没有交给下游的消息 */
+static void rx_discard(const rp2040_msg_t* msg) {
+    switch (msg->type) {
+    case RP2040_MSG_JSON:
+        rx_pool_put(&jsonObjectPool, msg->data);
+        break;
+    case RP2040_MSG_BIN_FRAME:
+        rx_pool_put(&binFramePool, msg->data);
+        break;
+    case RP2040_MSG_IMAGE:
+        frame_buf_unref((frame_buf_t*)msg->data);
+        break;
+    }
+}
+
+/**
+ * 按策略从队列中挤掉 types 类的旧消息, 为 incoming 类型的新消息腾出位置
+ * @return 是否挤掉了消息
+ */
+static bool rx_make_room(uint32_t types, rp2040_msg_type_t incoming) {
+    rp2040_msg_t old;
+
+    if (rx_policy == RP2040_RX_DROP_OLDEST_IMAGE) {
+        if (!((types & RP2040_RX_MASK_IMAGE) && rx_evict(types & RP2040_RX_MASK_IMAGE, &old)) &&
+            !rx_evict(types, &old)) {
+            return false;
+        }
+        rx_discard(&old);
+        rx_stats.dropped++;
+        return true;
+    }
+
+    // COALESCE_LATEST: 全部换成新消息; JSON 模式下最后一张图像等的就是正在到达的检测结果, 保留
+    bool evicted = false;
+    rp2040_msg_t last;
+    while (rx_evict(types, &old)) {
+        if (evicted) {
+            rx_discard(&last);
+            rx_stats.overwritten++;
+        }
+        last = old;
+        evicted = true;
+    }
+    if (evicted) {
+        if (last.type == RP2040_MSG_IMAGE && incoming == RP2040_MSG_JSON && rx_sink(&last)) {
+            return true;
+        }
+        rx_discard(&last);
+        rx_stats.overwritten++;
+    }
+    return evicted;
+}
+
+/* 缓冲区都被队列中的消息占着时, 按策略挤掉一条 */
+static void* rx_pool_get(rx_pool_t* pool) {
+    void* buf = rx_pool_try_get(pool);
+    if (buf == NULL && rx_make_room(RP2040_RX_MASK(pool->type), pool->type)) {
+        buf = rx_pool_try_get(pool);
+    }
+    if (buf == NULL) {
+        rx_stats.dropped++;
+    }
+    return buf;
+}
+
+static char waitingBuffer[MAX_JSON_BUFFER_SIZE];
+static int waitingBufferSize = 0;
+static bool waitingBufferOverflow = false;
+
+typedef enum {
+    RX_STATE_LINE,       // 换行结尾的 JSON
+    RX_STATE_IMG,        // JSON 行中 "img" 字段的 base64 字符串
+    RX_STATE_BIN_HEADER, // 二进制帧头
+    RX_STATE_BIN_BODY,   // 二进制帧负载 + CRC
+    RX_STATE_CTRL,       // 0x00 之间的 COBS 控制包, 结束后回到 ctrlReturn
+} rx_state_t;
+
+static rx_state_t rx_state = RX_STATE_LINE;
+static uint8_t* binFrame = NULL;
+static size_t binFrameSize = 0;
+static size_t binFrameLen = 0;
+
+static uint8_t ctrlPacket[CTRL_PACKET_MAX_SIZE];
+static size_t ctrlLen = 0;
+static rx_state_t ctrlReturn = RX_STATE_LINE;
+
+static frame_buf_t* imgFrame = NULL;
+static b64_stream_t imgStream;
+static bool imgFieldClosed = false;
+
+static void rx_send(rp2040_msg_type_t type, void* data) {
+    rp2040_msg_t msg = {.type = type, .data = data, .t_rx = esp_timer_get_time()};
+    rx_stats.received++;
+
+    // Directly send object pointers to the queue to avoid duplication
+    if (rx_sink(&msg) || (rx_make_room(RP2040_RX_MASK_ALL, type) && rx_sink(&msg))) {
+        return;
+    }
+    ESP_LOGE(TAG, "Failed to send message %d to queue.", type);
+    rx_stats.dropped++;
+    rx_discard(&msg);
+}
+
+static void rx_line_complete(void) {
+    while (waitingBufferSize > 0 && waitingBuffer[waitingBufferSize - 1] == '\r') {
+        waitingBufferSize--;
+    }
+    // 只剩 "{}" 说明这一行只有图像, 已经单独发送
+    bool is_empty = waitingBufferSize == 2 && waitingBuffer[1] == '}';
+    char* jsonObject = NULL;
+    if (!waitingBufferOverflow && waitingBufferSize > 0 && !is_empty &&
+        (jsonObject = rx_pool_get(&jsonObjectPool)) == NULL) {
+        ESP_LOGW(TAG, "No free JSON buffer, drop line");
+    }
+    if (jsonObject != NULL) {
+        memcpy(jsonObject, waitingBuffer, waitingBufferSize);
+        jsonObject[waitingBufferSize] = '\0';
+        rx_send(RP2040_MSG_JSON, jsonObject);
+    }
+    waitingBufferSize = 0;
+    waitingBufferOverflow = false;
+    imgFieldClosed = false;
+}
+
+static void rx_img_begin(void) {
+    imgFrame = frame_buf_alloc();
+    if (imgFrame == NULL && rx_make_room(RP2040_RX_MASK(RP2040_MSG_IMAGE), RP2040_MSG_IMAGE)) {
+        imgFrame = frame_buf_alloc();
+    }
+    if (imgFrame == NULL) {
+        rx_stats.dropped++;
+        ESP_LOGW(TAG, "No free frame buffer, drop image");
+        b64_stream_init(&imgStream, NULL, 0);
+    } else {
+        b64_stream_init(&imgStream, imgFrame->data, imgFrame->size);
+    }
+}
+
+static void rx_img_complete(bool ok) {
+    ok = b64_stream_finish(&imgStream) && ok;
+    if (imgFrame == NULL) {
+        return;
+    }
+    if (!ok || imgStream.len == 0) {
+        ESP_LOGE(TAG, "Failed to decode image, %zu bytes", imgStream.len);
+        frame_buf_unref(imgFrame);
+    } else {
+        imgFrame->len = imgStream.len;
+        rx_send(RP2040_MSG_IMAGE, imgFrame);
+    }
+    imgFrame = NULL;
+}
+
+static void rx_bin_frame_complete(void) {
+    if (!frame_proto_verify(binFrame, binFrameSize)) {
+        ESP_LOGE(TAG, "Binary frame CRC mismatch, drop %zu bytes.", binFrameSize);
+        rx_stats.errors++;
+        rx_pool_put(&binFramePool, binFrame);
+        return;
+    }
+    rx_send(RP2040_MSG_BIN_FRAME, binFrame);
+}
+
+static void rx_ctrl_begin(rx_state_t from) {
+    ctrlLen = 0;
+    ctrlReturn = from;
+    rx_state = RX_STATE_CTRL;
+}
+
+static void rx_ctrl_complete(void) {
+    uint8_t decoded[CTRL_PACKET_MAX_SIZE];
+    cobs_decode_result ret = cobs_decode(decoded, sizeof(decoded), ctrlPacket, ctrlLen);
+    if (ret.status != COBS_DECODE_OK) {
+        ESP_LOGE(TAG, "Bad control packet, %d bytes", (int)ctrlLen);
+        rx_stats.errors++;
+        return;
+    }
+    if (rx_ctrl != NULL) {
+        rx_ctrl(decoded, ret.out_len);
+    }
+}
+
+void rp2040_rx_feed(const uint8_t* data, int len) {
+    int i = 0;
+    while (i < len) {
+        switch (rx_state) {
+        case RX_STATE_LINE: {
+            if (data[i] == 0x00) { // JSON 行中没有 0x00, 一定是控制包
+                i++;
+                rx_ctrl_begin(RX_STATE_LINE);
+                break;
+            }
+            if (waitingBufferSize == 0 && !waitingBufferOverflow) {
+                if (data[i] == FRAME_PROTO_MAGIC0) {
+                    binFrame = rx_pool_get(&binFramePool);
+                    if (binFrame == NULL) { // 当作杂散字节丢弃, 在后面重新同步
+                        ESP_LOGW(TAG, "No free binary frame buffer, drop frame");
+                        i++;
+                        break;
+                    }
+                    binFrameLen = 0;
+                    rx_state = RX_STATE_BIN_HEADER;
+                    break;
+                }
+                if (data[i] != '{') { // 丢弃消息之间的杂散字节, 用于帧错误后重新同步
+                    i++;
+                    break;
+                }
+            }
+            uint8_t c = data[i++];
+            if (c == '\n') { // Use line breaks as end markers
+                rx_line_complete();
+                break;
+            }
+            if (waitingBufferOverflow) {
+                break;
+            }
+            if (imgFieldClosed) { // 去掉图像字段两侧多余的逗号, 保持剩余部分是合法的 JSON
+                imgFieldClosed = false;
+                char prev = waitingBuffer[waitingBufferSize - 1];
+                if (c == ',' && (prev == '{' || prev == ',')) {
+                    break;
+                }
+                if (c == '}' && prev == ',') {
+                    waitingBufferSize--;
+                }
+            }
+            if (waitingBufferSize + 1 >= MAX_JSON_BUFFER_SIZE) {
+                ESP_LOGE(TAG, "Waiting buffer overflow, drop line.");
+                rx_stats.errors++;
+                waitingBufferOverflow = true;
+                break;
+            }
+            waitingBuffer[waitingBufferSize++] = c;
+            if (c == '"' && waitingBufferSize >= (int)IMG_FIELD_LEN &&
+                memcmp(waitingBuffer + waitingBufferSize - IMG_FIELD_LEN, IMG_FIELD, IMG_FIELD_LEN) == 0) {
+                waitingBufferSize -= IMG_FIELD_LEN;
+                rx_img_begin();
+                rx_state = RX_STATE_IMG;
+            }
+            break;
+        }
+        case RX_STATE_IMG: {
+            i += b64_stream_feed(&imgStream, data + i, len - i);
+            if (i == len) {
+                break;
+            }
+            if (data[i] == 0x00) {
+                i++;
+                rx_ctrl_begin(RX_STATE_IMG);
+                break;
+            }
+            if (data[i] == '"') { // JPEG 在收到结束引号时就已经解码完成
+                i++;
+                rx_img_complete(true);
+                imgFieldClosed = true;
+            } else {
+                ESP_LOGE(TAG, "Unexpected 0x%02x in image string.", data[i]);
+                rx_stats.errors++;
+                rx_img_complete(false);
+                waitingBufferOverflow = true; // 丢弃到行尾
+            }
+            rx_state = RX_STATE_LINE;
+            break;
+        }
+        case RX_STATE_BIN_HEADER: {
+            int n = FRAME_PROTO_HEADER_SIZE - binFrameLen;
+            n = n < len - i ? n : len - i;
+            memcpy(binFrame + binFrameLen, data + i, n);
+            binFrameLen += n;
+            i += n;
+            if (binFrameLen == FRAME_PROTO_HEADER_SIZE) {
+                binFrameSize = frame_proto_frame_size(binFrame);
+                if (binFrameSize == 0) {
+                    ESP_LOGE(TAG, "Invalid binary frame header, resync.");
+                    rx_stats.errors++;
+                    rx_pool_put(&binFramePool, binFrame);
+                    rx_state = RX_STATE_LINE;
+                } else {
+                    rx_state = RX_STATE_BIN_BODY;
+                }
+            }
+            break;
+        }
+        case RX_STATE_BIN_BODY: {
+            int n = binFrameSize - binFrameLen;
+            n = n < len - i ? n : len - i;
+            memcpy(binFrame + binFrameLen, data + i, n);
+            binFrameLen += n;
+            i += n;
+            if (binFrameLen == binFrameSize) {
+                rx_bin_frame_complete();
+                rx_state = RX_STATE_LINE;
+            }
+            break;
+        }
+        case RX_STATE_CTRL: {
+            const uint8_t* end = memchr(data + i, 0x00, len - i);
+            int n = (end ? end - data : len) - i;
+            if (ctrlLen + n > sizeof(ctrlPacket)) {
+                // 多半是线路上的杂散 0x00, 不再等结束的 0x00, 被打断的行已经不完整
+                ESP_LOGE(TAG, "Control packet too long, resync.");
+                rx_stats.errors++;
+                if (ctrlReturn == RX_STATE_IMG) {
+                    rx_img_complete(false);
+                }
+                waitingBufferOverflow = waitingBufferSize > 0;
+                rx_state = RX_STATE_LINE;
+                break;
+            }
+            memcpy(ctrlPacket + ctrlLen, data + i, n);
+            ctrlLen += n;
+            i += n;
+            if (end == NULL) {
+                break;
+            }
+            i++;
+            if (ctrlLen == 0) { // 相邻两个包之间的分隔符
+                break;
+            }
+            rx_ctrl_complete();
+            rx_state = ctrlReturn;
+            break;
+        }
+        }
+    }
+}
+
+void rp2040_rx_reset(void) {
+    if (rx_state == RX_STATE_CTRL) {
+        rx_state = ctrlReturn;
+    }
+    if (rx_state == RX_STATE_IMG) {
+        rx_img_complete(false);
+    } else if (rx_state == RX_STATE_BIN_HEADER || rx_state == RX_STATE_BIN_BODY) {
+        rx_pool_put(&binFramePool, binFrame);
+    }
+    rx_state = RX_STATE_LINE;
+    waitingBufferSize = 0;
+    waitingBufferOverflow = false;
+    imgFieldClosed = false;
+}
+
+void rp2040_rx_release(const rp2040_msg_t* msg) {
+    if (msg->type != RP2040_MSG_IMAGE) {
+        rx_discard(msg);
+    }
+}
+
+void rp2040_rx_set_policy(rp2040_rx_policy_t policy) {
+    rx_policy = policy;
+}
+
+void rp2040_rx_set_ctrl_handler(rp2040_rx_ctrl_t handler) {
+    rx_ctrl = handler;
+}
+
+void rp2040_rx_get_stats(rp2040_rx_stats_t* stats) {
+    *stats = rx_stats;
+}
+
+esp_err_t rp2040_rx_init(rp2040_rx_sink_t sink, rp2040_rx_evict_t evict, rp2040_rx_policy_t policy) {
+    rx_sink = sink;
+    rx_evict = evict;
+    rx_policy = policy;
+
+    for (int i = 0; i < JSON_OBJECT_POOL_SIZE; i++) {
+        atomic_init(&jsonObjectPool.used[i], false);
+        jsonObjectPool.buf[i] = heap_caps_malloc(MAX_JSON_BUFFER_SIZE, MALLOC_CAP_SPIRAM);
+        if (jsonObjectPool.buf[i] == NULL) {
+            ESP_LOGE(TAG, "JSON object pool alloc failed");
+            return ESP_ERR_NO_MEM;
+        }
+    }
+    for (int i = 0; i < BIN_FRAME_POOL_SIZE; i++) {
+        atomic_init(&binFramePool.used[i], false);
+        binFramePool.buf[i] = heap_caps_malloc(FRAME_PROTO_MAX_FRAME_SIZE, MALLOC_CAP_SPIRAM);
+        if (binFramePool.buf[i] == NULL) {
+            ESP_LOGE(TAG, "Binary frame pool alloc failed");
+            return ESP_ERR_NO_MEM;
+        }
+    }
+    return ESP_OK;
+}
@@ -0,0 +1,113 @@
+/**
+ * @file rp2040_rx.h
+ * @date  16 October 2026
+
+ * @author Spencer Yan
+ *
+ * @note Splits the byte stream from the RP2040 into JSON lines, streamed images, binary frames and control packets
+ *
+ * @copyright © 2026, Seeed Studio
+ */
+
+#ifndef RP2040_RX_H
+#define RP2040_RX_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "esp_err.h"
+#include "esp32_rp2040.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define RP2040_RX_MASK(type) (1u << (type))
+#define RP2040_RX_MASK_IMAGE (RP2040_RX_MASK(RP2040_MSG_IMAGE) | RP2040_RX_MASK(RP2040_MSG_BIN_FRAME))
+#define RP2040_RX_MASK_ALL (RP2040_RX_MASK_IMAGE | RP2040_RX_MASK(RP2040_MSG_JSON))
+
+/**
+ * 下游跟不上时的处理方式. 队列满, 或者 JSON 行, 二进制帧, 图像的缓冲区都被
+ * 队列中的消息占着时, 按策略从队列中挤掉旧消息, 不会覆盖还没处理的缓冲区.
+ */
+typedef enum {
+    RP2040_RX_DROP_OLDEST_IMAGE, // 先丢最早的图像, 尽量保留检测结果
+    RP2040_RX_COALESCE_LATEST,   // 丢掉队列中所有旧消息, 只保留最新的一帧
+} rp2040_rx_policy_t;
+
+typedef struct {
+    uint32_t received;    // 接收完整的消息
+    uint32_t dropped;     // 没有空间而丢掉的消息, 包括 DROP_OLDEST_IMAGE 挤掉的
+    uint32_t overwritten; // 还在队列中就被 COALESCE_LATEST 的新消息替换掉的
+    uint32_t errors;      // CRC, 帧头或图像字符串错误, 以及过长的行, 通常是线路误码
+} rp2040_rx_stats_t;
+
+/**
+ * @brief 接收到一条完整消息时调用
+ *
+ * @param msg 消息, 回调返回后失效, 需要复制
+ * @return false 表示队列满, 不等待
+ */
+typedef bool (*rp2040_rx_sink_t)(const rp2040_msg_t* msg);
+
+/**
+ * @brief 从队列中取出最早的一条类型在 types 中的消息, 其余消息保持顺序
+ *
+ * @param types RP2040_RX_MASK() 的组合
+ * @param out 取出的消息
+ * @return false 表示队列中没有这类消息
+ */
+typedef bool (*rp2040_rx_evict_t)(uint32_t types, rp2040_msg_t* out);
+
+/**
+ * @brief 收到一个控制包时调用, 在调用 rp2040_rx_feed() 的任务中
+ *
+ * @param pkt COBS 解码后的内容, 回调返回后失效
+ * @param len 长度
+ */
+typedef void (*rp2040_rx_ctrl_t)(const uint8_t* pkt, size_t len);
+
+/**
+ * @brief 分配 JSON 行和二进制帧的缓冲池
+ *
+ * @param sink 消息出口, 固件中是 JsonQueue
+ * @param evict 从 sink 的队列中挤掉旧消息
+ * @param policy 下游跟不上时的处理方式
+ */
+esp_err_t rp2040_rx_init(rp2040_rx_sink_t sink, rp2040_rx_evict_t evict, rp2040_rx_policy_t policy);
+
+/**
+ * @brief 下游处理完一条 JSON 行或二进制帧后归还缓冲区
+ * @note  RP2040_MSG_IMAGE 的图像归接收方所有, 这里不处理
+ */
+void rp2040_rx_release(const rp2040_msg_t* msg);
+
+void rp2040_rx_set_policy(rp2040_rx_policy_t policy);
+
+/**
+ * @brief 设置控制包的出口, 没有设置时控制包被丢弃
+ * @note  控制包以 0x00 开头和结尾, 可以出现在消息之间或者 JSON 行的中间, 见 rp2040_cmd.h
+ */
+void rp2040_rx_set_ctrl_handler(rp2040_rx_ctrl_t handler);
+void rp2040_rx_get_stats(rp2040_rx_stats_t* stats);
+
+/**
+ * @brief 输入从 UART 读到的字节, 可以在任意位置分段
+ *
+ * @param data 数据
+ * @param len 长度
+ */
+void rp2040_rx_feed(const uint8_t* data, int len);
+
+/**
+ * @brief 丢弃收到一半的消息, 从下一条消息开始重新同步
+ * @note  UART 接收溢出后调用
+ */
+void rp2040_rx_reset(void);
+
+#ifdef __cplusplus
+} /*extern "C"*/
+#endif
+
+#endif /*RP2040_RX_H*/
@@ -0,0 +1,468 @@
+/**
+ * @file sscma_parser.c
+ * @date  16 October 2026
+
+ * @author Spencer Yan
+ *
+ * @note Single-pass parser for the JSON lines sent by the RP2040, replaces the cJSON DOM
+ *
+ * @copyright © 2026, Seeed Studio
+ */
+
+#include "sscma_parser.h"
+#include "frame_proto.h"
+#include <limits.h>
+#include <string.h>
+
+#define SKIP_MAX_DEPTH (16)
+
+typedef struct {
+    const char* p;
+    const char* end;
+    sscma_result_t* result;
+    keypoints_t* person; // parse_person() 正在填写的人
+    keypoints_t spare;   // 超出 SSCMA_MAX_PERSONS 时用来做语法检查, 不保存关键点
+} cursor_t;
+
+static inline void skip_ws(cursor_t* c) {
+    while (c->p < c->end && (*c->p == ' ' || *c->p == '\t' || *c->p == '\r' || *c->p == '\n')) {
+        c->p++;
+    }
+}
+
+// 跳过空白后, 如果下一个字符是 ch 就吃掉它
+static inline bool accept(cursor_t* c, char ch) {
+    skip_ws(c);
+    if (c->p < c->end && *c->p == ch) {
+        c->p++;
+        return true;
+    }
+    return false;
+}
+
+static bool parse_string(cursor_t* c, const char** str, size_t* len) {
+    if (!accept(c, '"')) return false;
+
+    const char* start = c->p;
+    while (c->p < c->end && *c->p != '"') {
+        if (*c->p == '\\') c->p++; // 转义字符原样保留, 这里只需要找到结尾
+        c->p++;
+    }
+    if (c->p >= c->end) return false;
+
+    *str = start;
+    *len = c->p - start;
+    c->p++;
+    return true;
+}
+
+// 与 cJSON 的 valueint 一致: 小数部分截断, 超出范围饱和
+static bool parse_int(cursor_t* c, int* value) {
+    skip_ws(c);
+    const char* start = c->p;
+    bool neg = false;
+    long long v = 0;
+
+    if (c->p < c->end && *c->p == '-') {
+        neg = true;
+        c->p++;
+    }
+    while (c->p < c->end && *c->p >= '0' && *c->p <= '9') {
+        if (v <= INT_MAX) v = v * 10 + (*c->p - '0');
+        c->p++;
+    }
+    if (c->p == start || (neg && c->p == start + 1)) return false;
+
+    // 小数和指数部分不影响取整后的结果 (RP2040 只发送整数), 直接跳过
+    while (c->p < c->end && (*c->p == '.' || *c->p == 'e' || *c->p == 'E' || *c->p == '+' || *c->p == '-' ||
+                             (*c->p >= '0' && *c->p <= '9'))) {
+        c->p++;
+    }
+
+    if (neg) v = -v;
+    if (v > INT_MAX) v = INT_MAX;
+    if (v < INT_MIN) v = INT_MIN;
+    *value = (int)v;
+    return true;
+}
+
+// 跳过任意一个值, 用于不认识的字段
+static bool skip_value(cursor_t* c) {
+    int depth = 0;
+
+    do {
+        skip_ws(c);
+        if (c->p >= c->end) return false;
+
+        switch (*c->p) {
+        case '"': {
+            const char* s;
+            size_t n;
+            if (!parse_string(c, &s, &n)) return false;
+            break;
+        }
+        case '{':
+        case '[':
+            if (++depth > SKIP_MAX_DEPTH) return false;
+            c->p++;
+            break;
+        case '}':
+        case ']':
+            if (--depth < 0) return false;
+            c->p++;
+            break;
+        default: // 数字, true, false, null 以及 ',' ':'
+            c->p++;
+            while (c->p < c->end && !strchr(",:{}[]\" \t\r\n", *c->p)) {
+                c->p++;
+            }
+            break;
+        }
+    } while (depth > 0);
+
+    return true;
+}
+
+/**
+ * 解析一个数字数组, 前 max_cols 个写入 out, 多余的丢弃
+ * @return 数组中的元素个数, -1 表示语法错误
+ */
+static int parse_row(cursor_t* c, uint16_t* out, int max_cols) {
+    int n = 0;
+    if (!accept(c, '[')) return -1;
+    if (accept(c, ']')) return 0;
+
+    do {
+        int v;
+        if (!parse_int(c, &v)) return -1;
+        if (n < max_cols) out[n] = (uint16_t)v;
+        n++;
+    } while (accept(c, ','));
+
+    return accept(c, ']') ? n : -1;
+}
+
+/**
+ * 遍历一个数组, 对每个元素调用 item(), 元素的个数由 item() 自己管理
+ */
+static bool parse_array(cursor_t* c, bool (*item)(cursor_t* c)) {
+    if (!accept(c, '[')) return false;
+    if (accept(c, ']')) return true;
+
+    do {
+        if (!item(c)) return false;
+    } while (accept(c, ','));
+
+    return accept(c, ']');
+}
+
+static bool parse_box(cursor_t* c) {
+    sscma_result_t* r = c->result;
+    boxes_t box;
+    int n = parse_row(c, box.boxArray, 6);
+    if (n < 0) return false;
+    if (n < 6) return true; // 与原来的 cJSON 实现一致, 不完整的框直接忽略
+
+    if (r->boxes_count < SSCMA_MAX_BOXES) {
+        r->boxes[r->boxes_count++] = box;
+    } else {
+        r->truncated = true;
+    }
+    return true;
+}
+
+static bool parse_class(cursor_t* c) {
+    sscma_result_t* r = c->result;
+    uint16_t row[2] = {0};
+    if (parse_row(c, row, 2) < 0) return false;
+
+    if (r->classes_count < SSCMA_MAX_CLASSES) {
+        r->classes[r->classes_count].score = row[0];
+        r->classes[r->classes_count].target = row[1];
+        r->classes_count++;
+    } else {
+        r->truncated = true;
+    }
+    return true;
+}
+
+static bool parse_point(cursor_t* c) {
+    sscma_result_t* r = c->result;
+    sscma_point_t point = {0};
+    if (parse_row(c, point.pointArray, 4) < 0) return false;
+
+    if (r->points_count < SSCMA_MAX_POINTS) {
+        r->points[r->points_count++] = point;
+    } else {
+        r->truncated = true;
+    }
+    return true;
+}
+
+static bool parse_person_point(cursor_t* c) {
+    sscma_result_t* r = c->result;
+    keypoints_t* kp = c->person;
+    keypoint_t point = {0};
+    if (parse_row(c, point.point, 3) < 0) return false;
+    if (kp == &c->spare) return true;
+
+    // 同一个人的点之间没有其他分配, arena 保证它们是连续的
+    keypoint_t* slot = frame_arena_alloc(&r->arena, sizeof(keypoint_t), __alignof__(keypoint_t));
+    if (slot == NULL) {
+        r->truncated = true;
+        return true;
+    }
+    if (kp->points == NULL) kp->points = slot;
+    *slot = point;
+    kp->points_count++;
+    return true;
+}
+
+static bool parse_person(cursor_t* c) {
+    sscma_result_t* r = c->result;
+
+    bool full = r->keypoints_count >= SSCMA_MAX_PERSONS;
+    keypoints_t* kp = full ? &c->spare : &r->keypoints[r->keypoints_count];
+    memset(kp, 0, sizeof(*kp));
+    c->person = kp;
+
+    // SSCMA 原始格式 (FRAME_MODE_PASSTHROUGH): [box, [[x, y, score, target], ...]]
+    if (accept(c, '[')) {
+        boxes_t box = {0};
+        int n = parse_row(c, box.boxArray, 6);
+        if (n < 0 || !accept(c, ',') || !parse_array(c, parse_person_point) || !accept(c, ']')) return false;
+        if (n == 6) kp->box = box;
+    } else if (!accept(c, '{')) {
+        return false;
+    } else if (!accept(c, '}')) {
+        do {
+            const char* key;
+            size_t key_len;
+            if (!parse_string(c, &key, &key_len) || !accept(c, ':')) return false;
+
+            if (key_len == 3 && memcmp(key, "box", 3) == 0) {
+                boxes_t box = {0};
+                int n = parse_row(c, box.boxArray, 6);
+                if (n < 0) return false;
+                if (n == 6) kp->box = box;
+            } else if (key_len == 6 && memcmp(key, "points", 6) == 0) {
+                if (!parse_array(c, parse_person_point)) return false;
+            } else if (!skip_value(c)) {
+                return false;
+            }
+        } while (accept(c, ','));
+        if (!accept(c, '}')) return false;
+    }
+
+    if (full) {
+        r->truncated = true;
+    } else {
+        r->keypoints_count++;
+    }
+    return true;
+}
+
+static bool parse_field(cursor_t* c, const char* key, size_t key_len) {
+    sscma_result_t* r = c->result;
+
+#define KEY_IS(name) (key_len == sizeof(name) - 1 && memcmp(key, name, key_len) == 0)
+    if (KEY_IS("boxes")) {
+        r->fields |= SSCMA_FIELD_BOXES;
+        return parse_array(c, parse_box);
+    }
+    if (KEY_IS("keypoints")) {
+        r->fields |= SSCMA_FIELD_KEYPOINTS;
+        return parse_array(c, parse_person);
+    }
+    if (KEY_IS("classes")) {
+        r->fields |= SSCMA_FIELD_CLASSES;
+        return parse_array(c, parse_class);
+    }
+    if (KEY_IS("points")) {
+        r->fields |= SSCMA_FIELD_POINTS;
+        return parse_array(c, parse_point);
+    }
+    if (KEY_IS("img")) {
+        r->fields |= SSCMA_FIELD_IMG;
+        return parse_string(c, &r->img, &r->img_len);
+    }
+    if (KEY_IS("perf")) {
+        uint16_t row[3] = {0};
+        r->fields |= SSCMA_FIELD_PERF;
+        if (parse_row(c, row, 3) < 0) return false;
+        r->perf.prepocess = row[0];
+        r->perf.inference = row[1];
+        r->perf.postprocess = row[2];
+        return true;
+    }
+    if (KEY_IS("seq")) {
+        r->fields |= SSCMA_FIELD_SEQ;
+        return parse_int(c, &r->seq);
+    }
+    if (KEY_IS("frame_mode")) {
+        r->fields |= SSCMA_FIELD_FRAME_MODE;
+        return parse_int(c, &r->frame_mode);
+    }
+#undef KEY_IS
+
+    return skip_value(c);
+}
+
+void sscma_result_clear(sscma_result_t* result) {
+    if (result->arena.base == NULL) {
+        frame_arena_init(&result->arena, result->arena_buf, sizeof(result->arena_buf));
+    }
+    frame_arena_reset(&result->arena);
+
+    result->fields = 0;
+    result->truncated = false;
+    result->boxes_count = 0;
+    result->classes_count = 0;
+    result->points_count = 0;
+    result->keypoints_count = 0;
+    result->img = NULL;
+    result->img_len = 0;
+    result->jpeg = NULL;
+    result->jpeg_len = 0;
+    result->frame_mode = 0;
+    result->seq = 0;
+}
+
+bool sscma_parse(const char* json, size_t len, sscma_result_t* result) {
+    cursor_t c = {.p = json, .end = json + len, .result = result};
+
+    sscma_result_clear(result);
+
+    if (!accept(&c, '{')) return false;
+    if (accept(&c, '}')) return true;
+
+    do {
+        const char* key;
+        size_t key_len;
+        if (!parse_string(&c, &key, &key_len) || !accept(&c, ':')) return false;
+        if (!parse_field(&c, key, key_len)) return false;
+    } while (accept(&c, ','));
+
+    return accept(&c, '}');
+}
+
+static inline void read_bin_box(const uint8_t* p, boxes_t* box) {
+    box->x = frame_proto_rd16(p);
+    box->y = frame_proto_rd16(p + 2);
+    box->w = frame_proto_rd16(p + 4);
+    box->h = frame_proto_rd16(p + 6);
+    box->score = p[8];
+    box->target = p[9];
+}
+
+// 每人 box(10) + count(1) + count * point(5)
+static bool parse_bin_keypoints(const uint8_t* data, size_t len, sscma_result_t* r) {
+    size_t offset = 0;
+
+    while (offset + FRAME_SEC_BOX_SIZE + 1 <= len) {
+        const uint8_t* p = data + offset;
+        size_t points_count = p[FRAME_SEC_BOX_SIZE];
+
+        offset += FRAME_SEC_BOX_SIZE + 1 + points_count * FRAME_SEC_KEYPOINT_SIZE;
+        if (offset > len) return false;
+
+        if (r->keypoints_count >= SSCMA_MAX_PERSONS) {
+            r->truncated = true;
+            continue;
+        }
+
+        keypoints_t* kp = &r->keypoints[r->keypoints_count];
+        read_bin_box(p, &kp->box);
+        kp->points = NULL;
+        if (points_count > 0) {
+            kp->points = frame_arena_alloc(&r->arena, points_count * sizeof(keypoint_t), __alignof__(keypoint_t));
+            if (kp->points == NULL) {
+                points_count = 0;
+                r->truncated = true;
+            }
+        }
+        kp->points_count = points_count;
+
+        p += FRAME_SEC_BOX_SIZE + 1;
+        for (size_t i = 0; i < points_count; i++, p += FRAME_SEC_KEYPOINT_SIZE) {
+            kp->points[i].x = frame_proto_rd16(p);
+            kp->points[i].y = frame_proto_rd16(p + 2);
+            kp->points[i].score = p[4];
+        }
+        r->keypoints_count++;
+    }
+    return true;
+}
+
+bool sscma_parse_bin(const uint8_t* frame, sscma_result_t* result) {
+    size_t offset = 0;
+    frame_section_t sec;
+
+    sscma_result_clear(result);
+
+    frame_proto_header_t hdr;
+    memcpy(&hdr, frame, sizeof(hdr));
+    result->fields |= SSCMA_FIELD_SEQ;
+    result->seq = hdr.seq;
+
+    while (frame_proto_next_section(frame, &offset, &sec)) {
+        switch (sec.type) {
+        case FRAME_SEC_JPEG:
+            result->fields |= SSCMA_FIELD_JPEG;
+            result->jpeg = sec.data;
+            result->jpeg_len = sec.len;
+            break;
+        case FRAME_SEC_BOXES:
+            result->fields |= SSCMA_FIELD_BOXES;
+            for (size_t i = 0; i + FRAME_SEC_BOX_SIZE <= sec.len; i += FRAME_SEC_BOX_SIZE) {
+                if (result->boxes_count >= SSCMA_MAX_BOXES) {
+                    result->truncated = true;
+                    break;
+                }
+                read_bin_box(sec.data + i, &result->boxes[result->boxes_count++]);
+            }
+            break;
+        case FRAME_SEC_CLASSES:
+            result->fields |= SSCMA_FIELD_CLASSES;
+            for (size_t i = 0; i + FRAME_SEC_CLASS_SIZE <= sec.len; i += FRAME_SEC_CLASS_SIZE) {
+                if (result->classes_count >= SSCMA_MAX_CLASSES) {
+                    result->truncated = true;
+                    break;
+                }
+                result->classes[result->classes_count].target = sec.data[i];
+                result->classes[result->classes_count].score = sec.data[i + 1];
+                result->classes_count++;
+            }
+            break;
+        case FRAME_SEC_POINTS:
+            result->fields |= SSCMA_FIELD_POINTS;
+            for (size_t i = 0; i + FRAME_SEC_POINT_SIZE <= sec.len; i += FRAME_SEC_POINT_SIZE) {
+                if (result->points_count >= SSCMA_MAX_POINTS) {
+                    result->truncated = true;
+                    break;
+                }
+                sscma_point_t* point = &result->points[result->points_count++];
+                point->x = frame_proto_rd16(sec.data + i);
+                point->y = frame_proto_rd16(sec.data + i + 2);
+                point->score = sec.data[i + 4];
+                point->target = sec.data[i + 5];
+            }
+            break;
+        case FRAME_SEC_KEYPOINTS:
+            result->fields |= SSCMA_FIELD_KEYPOINTS;
+            if (!parse_bin_keypoints(sec.data, sec.len, result)) return false;
+            break;
+        case FRAME_SEC_PERF:
+            if (sec.len >= 6) {
+                result->fields |= SSCMA_FIELD_PERF;
+                result->perf.prepocess = frame_proto_rd16(sec.data);
+                result->perf.inference = frame_proto_rd16(sec.data + 2);
+                result->perf.postprocess = frame_proto_rd16(sec.data + 4);
+            }
+            break;
+        default: // 新版本增加的 section
+            break;
+        }
+    }
+    return true;
+}
@@ -0,0 +1,135 @@
+/**
+ * @file sscma_parser.h
+ * @date  16 October 2026
+
+ * @author Spencer Yan
+ *
+ * @note Single-pass parser for the JSON lines sent by the RP2040, replaces the cJSON DOM
+ *
+ * @copyright © 2026, Seeed Studio
+ */
+
+#ifndef SSCMA_PARSER_H
+#define SSCMA_PARSER_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "app_boxes.h"
+#include "app_keypoints.h"
+#include "frame_arena.h"
+#include "main.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * 只认识 RP2040 发出的固定结构, 其他字段会被跳过:
+ *
+ *   {"boxes":[[x,y,w,h,score,target],...],
+ *    "classes":[[score,target],...],
+ *    "points":[[x,y,score,target],...],
+ *    "keypoints":[{"box":[x,y,w,h,score,target],"points":[[x,y,score],...]},...],
+ *    "perf":[preprocess,inference,postprocess],
+ *    "img":"<base64>",
+ *    "seq":N,
+ *    "frame_mode":N}
+ *
+ * 超出容量的元素会被丢弃并置位 truncated, 不会分配内存.
+ * 关键点从每个结果自带的 arena 中按需分配, 容量按 SSCMA_MAX_PERSONS 个人,
+ * 平均每人 SSCMA_MAX_PERSON_POINTS 个点计算, 单个人的点数不受限制.
+ */
+#define SSCMA_MAX_BOXES (32)
+#define SSCMA_MAX_CLASSES (16)
+#define SSCMA_MAX_POINTS (32)
+#ifndef SSCMA_MAX_PERSONS
+#define SSCMA_MAX_PERSONS (10)
+#endif
+#ifndef SSCMA_MAX_PERSON_POINTS
+#define SSCMA_MAX_PERSON_POINTS (17)
+#endif
+#define SSCMA_KEYPOINT_ARENA_SIZE (SSCMA_MAX_PERSONS * SSCMA_MAX_PERSON_POINTS * sizeof(keypoint_t))
+
+/* sscma_result_t.fields: 行里出现过的字段 */
+#define SSCMA_FIELD_BOXES (1 << 0)
+#define SSCMA_FIELD_CLASSES (1 << 1)
+#define SSCMA_FIELD_POINTS (1 << 2)
+#define SSCMA_FIELD_KEYPOINTS (1 << 3)
+#define SSCMA_FIELD_PERF (1 << 4)
+#define SSCMA_FIELD_IMG (1 << 5)
+#define SSCMA_FIELD_FRAME_MODE (1 << 6)
+#define SSCMA_FIELD_JPEG (1 << 7)
+#define SSCMA_FIELD_SEQ (1 << 8)
+
+typedef union {
+    struct {
+        uint16_t x;
+        uint16_t y;
+        uint16_t score;
+        uint16_t target;
+    };
+    uint16_t pointArray[4];
+} sscma_point_t;
+
+typedef struct {
+    uint32_t fields;
+    bool truncated;
+
+    boxes_t boxes[SSCMA_MAX_BOXES];
+    int boxes_count;
+
+    classes_t classes[SSCMA_MAX_CLASSES];
+    int classes_count;
+
+    sscma_point_t points[SSCMA_MAX_POINTS];
+    int points_count;
+
+    keypoints_t keypoints[SSCMA_MAX_PERSONS]; // points 从 arena 分配
+    int keypoints_count;
+    frame_arena_t arena; // sscma_result_clear() 时整体归还
+    uint8_t arena_buf[SSCMA_KEYPOINT_ARENA_SIZE] __attribute__((aligned(4)));
+
+    perf_t perf;
+
+    const char* img; // 指向输入中的 base64 字符串, 不含引号, 未以 '\0' 结尾
+    size_t img_len;
+
+    const uint8_t* jpeg; // 指向二进制帧中的 JPEG section
+    size_t jpeg_len;
+
+    int frame_mode;
+    int seq; // RP2040 给每次推理分配的序号, 16 位回绕
+} sscma_result_t;
+
+/**
+ * @brief 解析一行 JSON, 结果直接写入 result
+ *
+ * @param json 输入, 不要求以 '\0' 结尾
+ * @param len 输入长度
+ * @param result 输出, 每次调用都会被重置
+ * @return false 表示语法错误, result 中已解析的部分仍然有效
+ */
+bool sscma_parse(const char* json, size_t len, sscma_result_t* result);
+
+/**
+ * @brief 解析一个已校验的二进制帧 (frame_proto.h), 结果写入 result
+ *
+ * @param frame frame_proto_verify() 通过的整帧
+ * @param result 输出, 每次调用都会被重置
+ * @return false 表示 section 被截断
+ */
+bool sscma_parse_bin(const uint8_t* frame, sscma_result_t* result);
+
+/**
+ * @brief 清空 result 中的所有字段, 并归还 arena 中的关键点
+ * @note  result 须为全零初始化 (static 或 calloc), 首次调用时初始化 arena
+ */
+void sscma_result_clear(sscma_result_t* result);
+
+#ifdef __cplusplus
+} /*extern "C"*/
+#endif
+
+#endif /*SSCMA_PARSER_H*/
@@ -2,7 +2,6 @@
 #include "esp_err.h"
 #include "esp_log.h"
 #include "esp_timer.h"
-#include "rom/cache.h"
 #include "freertos/FreeRTOS.h"
 #include "freertos/task.h"
 #include "freertos/semphr.h"
@@ -11,15 +10,23 @@
 #include "bsp_board.h"
 #include "bsp_lcd.h"
 #include "indev/indev.h"
+#include "fb_sync.h"
+#include "frame_trace.h"
 #include "sdkconfig.h"
 
 
+#if CONFIG_LCD_LVGL_SRAM_STRIPE
+#define LV_PORT_BUFFER_HEIGHT           (CONFIG_LCD_LVGL_STRIPE_HEIGHT)
+#define LV_PORT_BUFFER_MALLOC           (MALLOC_CAP_INTERNAL | MALLOC_CAP_8BIT)
+#define LV_PORT_BUFFER_NUM              (2)
+#else
 #define LV_PORT_BUFFER_HEIGHT           (brd->LCD_HEIGHT)
 #define LV_PORT_BUFFER_MALLOC           (MALLOC_CAP_SPIRAM)
-// #define LV_PORT_BUFFER_HEIGHT           (100)
-// #define LV_PORT_BUFFER_MALLOC           (MALLOC_CAP_INTERNAL | MALLOC_CAP_8BIT)
+#define LV_PORT_BUFFER_NUM              (1)
+#endif
 
-#define LV_PORT_TASK_DELAY_MS           (5)
+#define LV_PORT_TASK_MIN_DELAY_MS       (1)     // 让出 CPU, 即使定时器已经到期
+#define LV_PORT_TASK_MAX_DELAY_MS       (500)   // 没有定时器时 (LV_NO_TIMER_READY) 的上限
 
 
 static char *TAG = "lvgl_port";
@@ -28,6 +35,8 @@ static lv_indev_t *indev_touchpad = NULL;
 static lv_indev_t *indev_button = NULL;
 static SemaphoreHandle_t lvgl_mutex = NULL;
 static TaskHandle_t lvgl_task_handle;
+static lv_disp_t *lvgl_disp;
+static int64_t tick_last_us;           // LVGL tick 已经推进到的时间
 
 #ifndef CONFIG_LCD_TASK_PRIORITY
 #define CONFIG_LCD_TASK_PRIORITY    5
@@ -40,8 +49,10 @@ static bool lv_port_flush_is_last(void);
 static IRAM_ATTR void touchpad_read(lv_indev_drv_t *indev_drv, lv_indev_data_t *data);
 static void disp_flush(lv_disp_drv_t *disp_drv, const lv_area_t *area, lv_color_t *color_p);
 static esp_err_t lv_port_tick_init(void);
+static void lv_port_tick_update(void);
 static void lvgl_task(void *args);
 static void lv_port_direct_mode_copy(void);
+static void lv_port_render_start(lv_disp_drv_t *drv);
 
 void lv_port_init(void)
 {
@@ -51,7 +62,8 @@ void lv_port_init(void)
     lv_port_tick_init();
 
     lvgl_mutex = xSemaphoreCreateMutex();
-    xTaskCreate(lvgl_task, "lvgl_task", 4096, NULL, CONFIG_LCD_TASK_PRIORITY, &lvgl_task_handle);
+    // 与 view_event_task 同在 core 0, core 1 留给接收, 解析和 JPEG 解码
+    xTaskCreatePinnedToCore(lvgl_task, "lvgl_task", 4096, NULL, CONFIG_LCD_TASK_PRIORITY, &lvgl_task_handle, 0);
 }
 
 void lv_port_sem_take(void)
@@ -59,6 +71,7 @@ void lv_port_sem_take(void)
     TaskHandle_t task = xTaskGetCurrentTaskHandle();
     if (lvgl_task_handle != task) {
         xSemaphoreTake(lvgl_mutex, portMAX_DELAY);
+        lv_port_tick_update();
     }
 }
 
@@ -70,6 +83,13 @@ void lv_port_sem_give(void)
     }
 }
 
+void lv_port_render_request(void)
+{
+    if (lvgl_task_handle != NULL && lvgl_task_handle != xTaskGetCurrentTaskHandle()) {
+        xTaskNotifyGive(lvgl_task_handle);
+    }
+}
+
 /**
  * @brief Tell LVGL that LCD flush done.
  *
@@ -99,7 +119,9 @@ static bool lv_port_flush_is_last(void)
  */
 static void disp_flush(lv_disp_drv_t *disp_drv, const lv_area_t *area, lv_color_t *color_p)
 {
-    (void)disp_drv;
+    if (lv_disp_flush_is_last(disp_drv)) {
+        frame_trace_flush();
+    }
 
     /*The most simple case (but also the slowest) to put all pixels to the screen one-by-one*/
     bsp_lcd_flush(area->x1, area->y1, area->x2 + 1, area->y2 + 1, (uint8_t *) color_p);
@@ -186,6 +208,10 @@ static void lv_port_disp_init(void)
     buffer_size = brd->LCD_WIDTH * LV_PORT_BUFFER_HEIGHT;
     buf1 = heap_caps_malloc(buffer_size * sizeof(lv_color_t), LV_PORT_BUFFER_MALLOC);
     assert(buf1);
+#if LV_PORT_BUFFER_NUM > 1
+    buf2 = heap_caps_malloc(buffer_size * sizeof(lv_color_t), LV_PORT_BUFFER_MALLOC);
+    assert(buf2);
+#endif
 #endif
     // initialize LVGL draw buffers
     lv_disp_draw_buf_init(&disp_buf, buf1, buf2, buffer_size);
@@ -205,11 +231,13 @@ static void lv_port_disp_init(void)
     bsp_lcd_set_cb(lv_port_flush_ready, NULL);
 
 #if CONFIG_LCD_LVGL_DIRECT_MODE
+    ESP_ERROR_CHECK(fb_sync_init());
+    disp_drv.render_start_cb = lv_port_render_start;
     bsp_lcd_flush_is_last_register(lv_port_flush_is_last);
     bsp_lcd_direct_mode_register(lv_port_direct_mode_copy);
 #endif
 
-    lv_disp_drv_register(&disp_drv);
+    lvgl_disp = lv_disp_drv_register(&disp_drv);
 }
 
 /**
@@ -259,38 +287,29 @@ static void lv_port_indev_init(void)
 }
 
 /**
- * @brief Task to generate ticks for LVGL.
- *
- * @param pvParam Not used.
+ * @brief Advance the LVGL tick to esp_timer_get_time().
+ * @note  Must hold lvgl_mutex. LVGL time then runs on the same clock as the vsync timestamps,
+ *        without waking a timer task every 2 ms.
  */
-static void lv_tick_inc_cb(void *data)
+static void lv_port_tick_update(void)
 {
-    uint32_t tick_inc_period_ms = *((uint32_t *) data);
+    int64_t now = esp_timer_get_time();
+    uint32_t elapsed_ms = (uint32_t)((now - tick_last_us) / 1000);
 
-    lv_tick_inc(tick_inc_period_ms);
+    if (elapsed_ms > 0) {
+        lv_tick_inc(elapsed_ms);
+        tick_last_us += (int64_t)elapsed_ms * 1000;
+    }
 }
 
 /**
- * @brief Create tick task for LVGL.
+ * @brief Start the LVGL tick from now.
  *
  * @return esp_err_t
  */
 static esp_err_t lv_port_tick_init(void)
 {
-    static const uint32_t tick_inc_period_ms = 2;
-    const esp_timer_create_args_t periodic_timer_args = {
-        .callback = lv_tick_inc_cb,
-        .name = "",     /* name is optional, but may help identify the timer when debugging */
-        .arg = &tick_inc_period_ms,
-        .dispatch_method = ESP_TIMER_TASK,
-        .skip_unhandled_events = true,
-    };
-
-    esp_timer_handle_t periodic_timer;
-    ESP_ERROR_CHECK(esp_timer_create(&periodic_timer_args, &periodic_timer));
-
-    /* The timer has been created but is not running yet. Start the timer now */
-    ESP_ERROR_CHECK(esp_timer_start_periodic(periodic_timer, tick_inc_period_ms * 1000));
+    tick_last_us = esp_timer_get_time();
 
     return ESP_OK;
 }
@@ -299,6 +318,7 @@ static esp_err_t lv_port_tick_init(void)
 /**
  * @brief Copy dirty area from last frame to current frame.
  * @note  It's useful only when enable lvgl direct-mode, and should be called behind the end of flushing in lvgl.
+ *        The copy runs on GDMA, lv_port_render_start() waits for it before the next frame is drawn.
  *
  */
 static void lv_port_direct_mode_copy(void)
@@ -309,41 +329,32 @@ static void lv_port_direct_mode_copy(void)
     uint8_t *buf1 = disp_refr->driver->draw_buf->buf1;
     uint8_t *buf2 = disp_refr->driver->draw_buf->buf2;
     int h_res = disp_refr->driver->hor_res;
-    int v_res = disp_refr->driver->ver_res;
 
     uint8_t *fb_from = buf_act;
     uint8_t *fb_to = (fb_from == buf1) ? buf2 : buf1;
 
-    int32_t i;
-    lv_coord_t x_start, x_end, y_start, y_end;
-    uint32_t copy_bytes_per_line;
-    uint32_t bytes_to_flush;
-    uint32_t bytes_per_line = h_res * 2;
-    uint8_t *from, *to;
-    uint8_t *flush_ptr;
-    // ESP_LOGI(TAG, "----- Area list ----");
-    for(i = 0; i < disp_refr->inv_p; i++) {
-        /*Refresh the unjoined areas*/
-        if(disp_refr->inv_area_joined[i] == 0) {
-            x_start = disp_refr->inv_areas[i].x1;
-            x_end = disp_refr->inv_areas[i].x2 + 1;
-            y_start = disp_refr->inv_areas[i].y1;
-            y_end = disp_refr->inv_areas[i].y2 + 1;
-
-            copy_bytes_per_line= (x_end - x_start) * 2;
-            from = fb_from + (y_start * h_res + x_start) * 2;
-            to = fb_to + (y_start * h_res + x_start) * 2;
-            for (int y = y_start; y < y_end; y++) {
-                memcpy(to, from, copy_bytes_per_line);
-                from += bytes_per_line;
-                to += bytes_per_line;
-            }
-            bytes_to_flush = (y_end - y_start) * bytes_per_line;
-            flush_ptr = fb_to + y_start * bytes_per_line;
-
-            Cache_WriteBack_Addr((uint32_t)(flush_ptr), bytes_to_flush);
+    fb_rect_t rects[FB_SYNC_MAX_RECTS];
+    int n = 0;
+    for (int32_t i = 0; i < disp_refr->inv_p && n < FB_SYNC_MAX_RECTS; i++) {
+        /*Copy the unjoined areas*/
+        if (disp_refr->inv_area_joined[i] == 0) {
+            const lv_area_t *area = &disp_refr->inv_areas[i];
+            rects[n++] = (fb_rect_t) {area->x1, area->y1, area->x2, area->y2};
         }
     }
+
+    n = fb_sync_merge(rects, n, h_res, sizeof(lv_color_t));
+    fb_sync_start(fb_to, fb_from, rects, n, h_res, sizeof(lv_color_t));
+}
+
+/**
+ * @brief Wait for the direct-mode copy before LVGL draws into the back buffer.
+ */
+static void lv_port_render_start(lv_disp_drv_t *drv)
+{
+    (void) drv;
+
+    fb_sync_wait();
 }
 #endif
 
@@ -354,10 +365,20 @@ static void lv_port_direct_mode_copy(void)
  */
 static void lvgl_task(void *args)
 {
+    bool render_requested = false;
+
     for (;;) {
         xSemaphoreTake(lvgl_mutex, portMAX_DELAY);
-        lv_task_handler();
+        lv_port_tick_update();
+        if (render_requested) {
+            // 不等下一个刷新周期, 这一轮就把失效区域画出来
+            lv_timer_ready(lvgl_disp->refr_timer);
+        }
+        uint32_t delay_ms = lv_timer_handler();
         xSemaphoreGive(lvgl_mutex);
-        vTaskDelay(pdMS_TO_TICKS(LV_PORT_TASK_DELAY_MS));
+
+        // 睡到下一个定时器到期, 期间的多次 lv_port_render_request() 合并成一次刷新
+        delay_ms = LV_CLAMP(LV_PORT_TASK_MIN_DELAY_MS, delay_ms, LV_PORT_TASK_MAX_DELAY_MS);
+        render_requested = ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(delay_ms)) > 0;
     }
 }
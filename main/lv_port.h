@@ -27,6 +27,14 @@ void lv_port_sem_take(void);
  */
 void lv_port_sem_give(void);
 
+/**
+ * @brief Ask the LVGL task to refresh now instead of at the next refresh period.
+ * @note  Call after invalidating areas, typically right after lv_port_sem_give().
+ *        Requests made before the LVGL task wakes up are merged into one refresh.
+ *
+ */
+void lv_port_render_request(void);
+
 #ifdef __cplusplus
 }
 #endif
@@ -1,4 +1,5 @@
 #include "bsp_board.h"
+#include "esp_console.h"
 #include "esp_event.h"
 #include "esp_event_base.h"
 #include "esp_log.h"
@@ -9,8 +10,7 @@
 
 #include "esp32_rp2040.h"
 #include "main.h"
-
-#include "cJSON.h"
+#include "sscma_parser.h"
 
 #include "mbedtls/base64.h"
 #include "string.h"
@@ -31,7 +31,14 @@
 #include "app_boxes.h"
 #include "app_image.h"
 #include "app_keypoints.h"
+#include "frame_clock.h"
+#include "frame_pipeline.h"
+#include "frame_pool.h"
+#include "frame_trace.h"
 #include "indicator_btn.h"
+#include "pixel_ops.h"
+#include "ui_bench.h"
+#include "view_frame.h"
 
 static const char* TAG = "app_main";
 
@@ -40,117 +47,108 @@ esp_event_loop_handle_t view_event_handle;
 
 void JsonQueue_processing_task(void* pvParameters);
 
+/**
+ * 三级流水线, 吞吐量只受最慢的一级限制:
+ *
+ *   esp32_rp2040_comm_task --JsonQueue--> frame_parse_task --decode_queue--> frame_decode_task
+ *     (core 1, UART/base64)              (core 1, 解析结果)                 (core 1, JPEG -> 后台画布)
+ *                                                                                 |
+ *                                          view_event_task (core 0) <--VIEW_EVENT_FRAME
+ *                                          (换上画布, 画叠加层)
+ *
+ * 解码不持有 lv_port_sem, 左侧画布使用两块缓冲区轮换, 空闲的那块在 canvas_free_queue 中.
+ */
+#define PIPELINE_WORK_CORE (1)
+#define PIPELINE_RENDER_CORE (0)
+#define FRAME_PARSE_TASK_PRIORITY (6)
+#define FRAME_DECODE_TASK_PRIORITY (5)
+#define CANVAS_LEFT_BUF_NUM (2)
+#define FRAME_TARGET_FPS (0) // 0: 跟随 RP2040 的帧率, 控制台 "fps N" 可以修改
+
+static QueueHandle_t decode_queue;      // view_frame_t*, 解析 -> 解码
+static QueueHandle_t canvas_free_queue; // uint8_t*, 当前没有显示的左侧画布缓冲区
+
 
 lv_obj_t* canvas_left;
 lv_obj_t* canvas_right;
 
 uint8_t* cbuf_left;
 uint8_t* cbuf_right;
-bool is_name_geted = false;
-
-#define BASE64_IMAGE_MAX_SIZE (15 * 1024)
-static unsigned char imageData[BASE64_IMAGE_MAX_SIZE] = {0};
-#define DECODED_IMAGE_MAX_SIZE (13 * 1024)
-static unsigned char jpegImage[DECODED_IMAGE_MAX_SIZE + 1];
 
 static bool is_right_canva_drawn = false;
 
-typedef struct {
-    keypoints_t* keypoints_array;
-    int keypoints_count;
-} keypoints_array_t;
-
-/* 处理JSON数据的函数 */
-static void process_json_data(cJSON* receivedJson) {
-    if (receivedJson == NULL) return;
-
-    /* 处理图像数据 */
-    cJSON* jsonImage = cJSON_GetObjectItem(receivedJson, "img");
-    if (cJSON_IsString(jsonImage) && jsonImage->valuestring) {
-        lv_memset_00(imageData, sizeof(imageData));
-        strncpy((char*)imageData, jsonImage->valuestring, sizeof(imageData) - 1);
-        esp_event_post_to(view_event_handle, VIEW_EVENT_BASE, VIEW_EVENT_IMG, imageData,
-                          sizeof(imageData), portMAX_DELAY);
+/* 解析完成, 交给解码任务; 队列长度与 view_frame_t 个数相同, 不会阻塞 */
+static void queue_for_decode(view_frame_t* frame) {
+    if (xQueueSend(decode_queue, &frame, portMAX_DELAY) != pdPASS) {
+        view_frame_free(frame);
     }
+}
 
-    /* 处理boxes数据 */
-    cJSON* jsonBoxes = cJSON_GetObjectItem(receivedJson, "boxes");
-    if (cJSON_IsArray(jsonBoxes)) {
-        int arraySize = cJSON_GetArraySize(jsonBoxes);
-        for (int i = 0; i < arraySize; i++) {
-            cJSON* boxJson = cJSON_GetArrayItem(jsonBoxes, i);
-            if (cJSON_IsArray(boxJson) && cJSON_GetArraySize(boxJson) >= 6) {
-                boxes_t box;
-                for (int j = 0; j < 6; j++) {
-                    cJSON* item = cJSON_GetArrayItem(boxJson, j);
-                    if (item) {
-                        box.boxArray[j] = item->valueint;
-                    }
-                }
-                esp_event_post_to(view_event_handle, VIEW_EVENT_BASE, VIEW_EVENT_BOXES, &box,
-                                  sizeof(box), portMAX_DELAY);
-            }
+static void frame_decode_task(void* pvParameters) {
+    view_frame_t* frame;
+    uint8_t* buf;
+
+    for (;;) {
+        if (xQueueReceive(decode_queue, &frame, portMAX_DELAY) != pdPASS) {
+            continue;
         }
-    }
+        view_frame_stamp(frame, VIEW_FRAME_TS_DECODE_START);
+        // 两块缓冲区都在用时, 等界面任务换下上一块
+        if (frame->img != NULL && xQueueReceive(canvas_free_queue, &buf, portMAX_DELAY) == pdPASS &&
+            !frame_pipeline_decode(frame, buf)) {
+            xQueueSend(canvas_free_queue, &buf, 0);
+        }
+        view_frame_stamp(frame, VIEW_FRAME_TS_DECODED);
 
-    /* 处理keypoints数据 */
-    cJSON* jsonKeypoints = cJSON_GetObjectItem(receivedJson, "keypoints");
-    if (cJSON_IsArray(jsonKeypoints)) {
-        keypoints_array_t keypoints_array;
-        if (ParseJsonKeypoints(jsonKeypoints, &keypoints_array.keypoints_array, &keypoints_array.keypoints_count) 
-            && keypoints_array.keypoints_array != NULL) {
-            esp_event_post_to(view_event_handle, VIEW_EVENT_BASE, VIEW_EVENT_KEYPOINTS, &keypoints_array,
-                              sizeof(keypoints_array_t), portMAX_DELAY);
+        // 交给界面, 之后由事件处理函数归还
+        if (esp_event_post_to(view_event_handle, VIEW_EVENT_BASE, VIEW_EVENT_FRAME, &frame, sizeof(frame),
+                              portMAX_DELAY) != ESP_OK) {
+            if (frame->canvas_buf != NULL) {
+                xQueueSend(canvas_free_queue, &frame->canvas_buf, 0);
+            }
+            view_frame_free(frame);
         }
     }
 }
 
-static void __json_event_handler(void* handler_args, esp_event_base_t base, int32_t id, void* event_data) {
+static void frame_parse_task(void* pvParameters) {
+    rp2040_msg_t msg;
 
-    static int right_canvs_delay = 0;
-    static bool is_right_canvas_cleaned = 0;
+    for (;;) {
+        esp32_rp2040_receive(&msg);
+        frame_pipeline_parse(&msg);
+    }
+}
 
+static void __json_event_handler(void* handler_args, esp_event_base_t base, int32_t id, void* event_data) {
     switch (id) {
-    case VIEW_EVENT_IMG: {
-        unsigned char* img_data = (unsigned char*)event_data;
+    case VIEW_EVENT_FRAME: {
+        view_frame_t* frame = *(view_frame_t**)event_data;
+        // 等到这一帧的 vsync 槽位再画, 每帧在屏上停留的刷新次数保持一致
+        frame_clock_pace(frame);
+        view_frame_stamp(frame, VIEW_FRAME_TS_RENDER_START);
 
-        size_t jpegImageSize = decode_base64_image(img_data, jpegImage);
-        if (!jpegImageSize) {
-            ESP_LOGE(TAG, "Failed to decode image");
-        }
         lv_port_sem_take();
-        if (!is_right_canvas_cleaned && ++right_canvs_delay >= 2) {
-            is_right_canvas_cleaned = true;
-            lv_canvas_fill_bg(canvas_right, lv_palette_main(LV_PALETTE_NONE), LV_OPA_COVER);
-        }
-        update_canvas_with_image(canvas_left, jpegImage, jpegImageSize);
+        // 换下来的画布缓冲区交还给解码任务
+        uint8_t* old = frame_pipeline_render(frame, canvas_left, canvas_right);
+        view_frame_stamp(frame, VIEW_FRAME_TS_RENDERED);
+        frame_trace_rendered(frame);
         lv_port_sem_give();
-        break;
-    }
+        lv_port_render_request();
 
-    case VIEW_EVENT_BOXES: {
-        boxes_t* box = (boxes_t*)event_data;
-        lv_port_sem_take();
-        draw_one_box(canvas_left, *box, lv_color_make(113, 235, 52));
-        lv_port_sem_give();
+        if (old != NULL) {
+            xQueueSend(canvas_free_queue, &old, 0);
+        }
+        view_frame_log_timing(frame);
+        view_frame_free(frame);
         break;
     }
-    case VIEW_EVENT_KEYPOINTS: {
-        keypoints_array_t* keypoints_array = (keypoints_array_t*)event_data;
-        keypoints_t* keypoints = keypoints_array->keypoints_array;
-        int keypoints_count = keypoints_array->keypoints_count;
-
-        right_canvs_delay = 0;
-        is_right_canvas_cleaned = false;
+    case VIEW_EVENT_MODEL_NAME: {
+        // RP2040 回复的模型名称, 以 '\0' 结尾
         lv_port_sem_take();
-        lv_canvas_fill_bg(canvas_right, lv_palette_main(LV_PALETTE_NONE), LV_OPA_COVER);
-        
-        draw_keypoints_array(canvas_left, keypoints, keypoints_count);
-        draw_keypoints_array(canvas_right, keypoints, keypoints_count);
-
+        lv_label_set_text(ui_Model_Name, (const char*)event_data);
         lv_port_sem_give();
-
-        free_all_keypoints(keypoints, keypoints_count);
+        lv_port_render_request();
         break;
     }
     case VIEW_EVENT_ALL: {
@@ -162,6 +160,29 @@ static void __json_event_handler(void* handler_args, esp_event_base_t base, int3
     }
 }
 
+static esp_console_repl_t* console_repl;
+
+/* 先创建控制台, 各模块再注册自己的命令, 全部注册完再启动 */
+static esp_err_t console_init(void) {
+    esp_err_t ret;
+    esp_console_repl_config_t repl_config = ESP_CONSOLE_REPL_CONFIG_DEFAULT();
+    repl_config.prompt = "indicator>";
+#if CONFIG_ESP_CONSOLE_USB_SERIAL_JTAG
+    esp_console_dev_usb_serial_jtag_config_t hw_config = ESP_CONSOLE_DEV_USB_SERIAL_JTAG_CONFIG_DEFAULT();
+    ret = esp_console_new_repl_usb_serial_jtag(&hw_config, &repl_config, &console_repl);
+#elif CONFIG_ESP_CONSOLE_USB_CDC
+    esp_console_dev_usb_cdc_config_t hw_config = ESP_CONSOLE_DEV_CDC_CONFIG_DEFAULT();
+    ret = esp_console_new_repl_usb_cdc(&hw_config, &repl_config, &console_repl);
+#else
+    esp_console_dev_uart_config_t hw_config = ESP_CONSOLE_DEV_UART_CONFIG_DEFAULT();
+    ret = esp_console_new_repl_uart(&hw_config, &repl_config, &console_repl);
+#endif
+    if (ret != ESP_OK) {
+        ESP_LOGE(TAG, "Failed to create console");
+    }
+    return ret;
+}
+
 void app_main(void) {
 
     ESP_ERROR_CHECK(bsp_board_init());
@@ -171,8 +192,21 @@ void app_main(void) {
                                                   .task_name = "view_event_task",
                                                   .task_priority = uxTaskPriorityGet(NULL),
                                                   .task_stack_size = 1024 * 5,
-                                                  .task_core_id = tskNO_AFFINITY};
+                                                  .task_core_id = PIPELINE_RENDER_CORE};
     ESP_ERROR_CHECK(esp_event_loop_create(&view_event_task_args, &view_event_handle));
+    ESP_ERROR_CHECK(frame_pool_init(DECODED_IMAGE_MAX_SIZE));
+    ESP_ERROR_CHECK(view_frame_pool_init());
+    ESP_ERROR_CHECK(console_init());
+    ESP_ERROR_CHECK(frame_trace_init());
+    frame_clock_init(FRAME_TARGET_FPS);
+    ui_bench_init();
+    frame_pipeline_init(queue_for_decode);
+    decode_queue = xQueueCreate(VIEW_FRAME_POOL_SIZE, sizeof(view_frame_t*));
+    canvas_free_queue = xQueueCreate(CANVAS_LEFT_BUF_NUM, sizeof(uint8_t*));
+    if (decode_queue == NULL || canvas_free_queue == NULL) {
+        ESP_LOGE(TAG, "Failed to create pipeline queues");
+        return;
+    }
 
     lv_port_sem_take();
     ui_init();
@@ -185,6 +219,17 @@ void app_main(void) {
         return;
     }
 
+    // 其余的左侧画布缓冲区交给解码任务轮换使用
+    for (int i = 1; i < CANVAS_LEFT_BUF_NUM; i++) {
+        uint8_t* back = (uint8_t*)heap_caps_calloc(1, LV_IMG_BUF_SIZE_TRUE_COLOR(CANVAS_WIDTH, CANVAS_HEIGHT),
+                                                   MALLOC_CAP_SPIRAM);
+        if (back == NULL) {
+            ESP_LOGE(TAG, "Failed to allocate memory for canvas buffers");
+            return;
+        }
+        xQueueSend(canvas_free_queue, &back, 0);
+    }
+
     canvas_left = lv_canvas_create(lv_scr_act());
     canvas_right = lv_canvas_create(lv_scr_act());
     
@@ -193,39 +238,25 @@ void app_main(void) {
 
     lv_obj_align(canvas_left, LV_ALIGN_LEFT_MID, 0, 0);
     lv_obj_align(canvas_right, LV_ALIGN_RIGHT_MID, 0, 0);
-    lv_canvas_fill_bg(canvas_left, lv_palette_main(LV_PALETTE_NONE), LV_OPA_COVER);
-    lv_canvas_fill_bg(canvas_right, lv_palette_main(LV_PALETTE_GREY), LV_OPA_COVER);
+    pixel_canvas_fill(canvas_left, lv_palette_main(LV_PALETTE_NONE));
+    pixel_canvas_fill(canvas_right, lv_palette_main(LV_PALETTE_GREY));
 
     init_image();
     init_keypoints_app();
     init_boxes_app();
     lv_port_sem_give();
 
-    ESP_ERROR_CHECK(esp_event_handler_instance_register_with(view_event_handle, VIEW_EVENT_BASE, VIEW_EVENT_IMG,
+    ESP_ERROR_CHECK(esp_event_handler_instance_register_with(view_event_handle, VIEW_EVENT_BASE, VIEW_EVENT_FRAME,
                                                              __json_event_handler, NULL, NULL));
-
-    ESP_ERROR_CHECK(esp_event_handler_instance_register_with(view_event_handle, VIEW_EVENT_BASE, VIEW_EVENT_BOXES,
-                                                             __json_event_handler, NULL, NULL));
-    ESP_ERROR_CHECK(esp_event_handler_instance_register_with(view_event_handle, VIEW_EVENT_BASE, VIEW_EVENT_KEYPOINTS,
+    ESP_ERROR_CHECK(esp_event_handler_instance_register_with(view_event_handle, VIEW_EVENT_BASE, VIEW_EVENT_MODEL_NAME,
                                                              __json_event_handler, NULL, NULL));
 
     esp32_rp2040_init();
     ESP_LOGI(TAG, "RP2040 init success");
+    ESP_ERROR_CHECK(esp_console_start_repl(console_repl));
 
-    char* receivedStr = NULL;
-
-    for (;;) {
-        if (xQueueReceive(JsonQueue, &receivedStr, portMAX_DELAY) == pdPASS && receivedStr != NULL) {
-            cJSON* receivedJson = cJSON_Parse(receivedStr);
-            if (receivedJson != NULL) {
-                process_json_data(receivedJson);
-                cJSON_Delete(receivedJson);
-            } else {
-                ESP_LOGE(TAG, "Invalid JSON string: %s", receivedStr);
-                vTaskDelay(pdMS_TO_TICKS(1));
-            }
-        }
-    }
-
-
-}
\ No newline at end of file
+    xTaskCreatePinnedToCore(frame_decode_task, "frame_decode_task", 1024 * 4, NULL, FRAME_DECODE_TASK_PRIORITY, NULL,
+                            PIPELINE_WORK_CORE);
+    xTaskCreatePinnedToCore(frame_parse_task, "frame_parse_task", 1024 * 4, NULL, FRAME_PARSE_TASK_PRIORITY, NULL,
+                            PIPELINE_WORK_CORE);
+}
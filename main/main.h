@@ -27,26 +27,16 @@
 extern "C" {
 #endif
 
-typedef struct {
-    char* img_base64; // 存储Base64编码的图像数据
-    int img_size;
-} img_event_data_t;
-
 ESP_EVENT_DECLARE_BASE(VIEW_EVENT_BASE);
 extern esp_event_loop_handle_t view_event_handle;
 
 enum {
-    VIEW_EVENT_MODEL_NAME,
-    VIEW_EVENT_IMG,
-    VIEW_EVENT_BOXES,
-    VIEW_EVENT_KEYPOINTS,
+    VIEW_EVENT_MODEL_NAME, // char[]: 以 '\0' 结尾的模型名称, 显示在标题上
+    VIEW_EVENT_FRAME, // view_frame_t*: 一帧的图像和全部检测结果
     VIEW_EVENT_PAGE_SWITCH,
     VIEW_EVENT_ALL,
 };
 
-extern QueueHandle_t JsonQueue;
-extern bool is_name_geted;
-
 typedef struct {
     uint8_t target;
     uint8_t score;
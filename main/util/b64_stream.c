@@ -0,0 +1,106 @@
+/**
+ * @file b64_stream.c
+ * @date  16 October 2026
+
+ * @author Spencer Yan
+ *
+ * @note Incremental base64 decoder, fed with whatever the UART delivers
+ *
+ * @copyright © 2026, Seeed Studio
+ */
+
+#include "b64_stream.h"
+
+#define X (-1) // 终止字符
+#define S (-2) // 跳过: 填充 '=' 和 JSON 转义 '\\'
+
+static const int8_t b64_dec[256] = {
+     X,  X,  X,  X,  X,  X,  X,  X,  X,  X,  X,  X,  X,  X,  X,  X,
+     X,  X,  X,  X,  X,  X,  X,  X,  X,  X,  X,  X,  X,  X,  X,  X,
+     X,  X,  X,  X,  X,  X,  X,  X,  X,  X,  X, 62,  X,  X,  X, 63,
+    52, 53, 54, 55, 56, 57, 58, 59, 60, 61,  X,  X,  X,  S,  X,  X,
+     X,  0,  1,  2,  3,  4,  5,  6,  7,  8,  9, 10, 11, 12, 13, 14,
+    15, 16, 17, 18, 19, 20, 21, 22, 23, 24, 25,  X,  S,  X,  X,  X,
+     X, 26, 27, 28, 29, 30, 31, 32, 33, 34, 35, 36, 37, 38, 39, 40,
+    41, 42, 43, 44, 45, 46, 47, 48, 49, 50, 51,  X,  X,  X,  X,  X,
+     X,  X,  X,  X,  X,  X,  X,  X,  X,  X,  X,  X,  X,  X,  X,  X,
+     X,  X,  X,  X,  X,  X,  X,  X,  X,  X,  X,  X,  X,  X,  X,  X,
+     X,  X,  X,  X,  X,  X,  X,  X,  X,  X,  X,  X,  X,  X,  X,  X,
+     X,  X,  X,  X,  X,  X,  X,  X,  X,  X,  X,  X,  X,  X,  X,  X,
+     X,  X,  X,  X,  X,  X,  X,  X,  X,  X,  X,  X,  X,  X,  X,  X,
+     X,  X,  X,  X,  X,  X,  X,  X,  X,  X,  X,  X,  X,  X,  X,  X,
+     X,  X,  X,  X,  X,  X,  X,  X,  X,  X,  X,  X,  X,  X,  X,  X,
+     X,  X,  X,  X,  X,  X,  X,  X,  X,  X,  X,  X,  X,  X,  X,  X,
+};
+
+#undef X
+#undef S
+
+void b64_stream_init(b64_stream_t* s, uint8_t* out, size_t size) {
+    s->out = out;
+    s->size = out ? size : 0;
+    s->len = 0;
+    s->acc = 0;
+    s->n = 0;
+    s->error = false;
+}
+
+size_t b64_stream_feed(b64_stream_t* s, const uint8_t* in, size_t len) {
+    uint32_t acc = s->acc;
+    uint8_t n = s->n;
+    size_t i;
+
+    for (i = 0; i < len; i++) {
+        int8_t v = b64_dec[in[i]];
+        if (v < 0) {
+            if (v == -2) {
+                continue;
+            }
+            break;
+        }
+        acc = (acc << 6) | (uint32_t)v;
+        if (++n == 4) {
+            if (s->len + 3 <= s->size) {
+                s->out[s->len++] = (uint8_t)(acc >> 16);
+                s->out[s->len++] = (uint8_t)(acc >> 8);
+                s->out[s->len++] = (uint8_t)acc;
+            } else {
+                s->error = true;
+            }
+            acc = 0;
+            n = 0;
+        }
+    }
+
+    s->acc = acc;
+    s->n = n;
+    return i;
+}
+
+bool b64_stream_finish(b64_stream_t* s) {
+    switch (s->n) {
+    case 0:
+        break;
+    case 2:
+        if (s->len + 1 <= s->size) {
+            s->out[s->len++] = (uint8_t)(s->acc >> 4);
+        } else {
+            s->error = true;
+        }
+        break;
+    case 3:
+        if (s->len + 2 <= s->size) {
+            s->out[s->len++] = (uint8_t)(s->acc >> 10);
+            s->out[s->len++] = (uint8_t)(s->acc >> 2);
+        } else {
+            s->error = true;
+        }
+        break;
+    default:
+        s->error = true; // 单个多余字符
+        break;
+    }
+    s->n = 0;
+    s->acc = 0;
+    return !s->error;
+}
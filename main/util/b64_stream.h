@@ -0,0 +1,53 @@
+/**
+ * @file b64_stream.h
+ * @date  16 October 2026
+
+ * @author Spencer Yan
+ *
+ * @note Incremental base64 decoder, fed with whatever the UART delivers
+ *
+ * @copyright © 2026, Seeed Studio
+ */
+
+#ifndef B64_STREAM_H
+#define B64_STREAM_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef struct {
+    uint8_t* out;  // 输出缓冲区, 为 NULL 时只消费输入
+    size_t size;   // out 的容量
+    size_t len;    // 已输出的字节数
+    uint32_t acc;  // 未满 4 个字符时的累加值
+    uint8_t n;     // acc 中的字符数
+    bool error;    // 输出溢出或长度不合法
+} b64_stream_t;
+
+void b64_stream_init(b64_stream_t* s, uint8_t* out, size_t size);
+
+/**
+ * @brief 解码 in 中的 base64 字符
+ * @note  '=' 和 '\\' 会被跳过, 遇到其它非 base64 字符时停止
+ *
+ * @return 消费的字节数, 小于 len 时 in[返回值] 为终止字符
+ */
+size_t b64_stream_feed(b64_stream_t* s, const uint8_t* in, size_t len);
+
+/**
+ * @brief 输出剩余的字节
+ *
+ * @return false 表示数据不完整或输出溢出
+ */
+bool b64_stream_finish(b64_stream_t* s);
+
+#ifdef __cplusplus
+} /*extern "C"*/
+#endif
+
+#endif /*B64_STREAM_H*/
@@ -0,0 +1,194 @@
+/**
+ * @file fb_sync.c
+ * @date  16 October 2026
+
+ * @author Spencer Yan
+ *
+ * @note Copies the dirty rectangles of the displayed framebuffer to the other one in LVGL direct mode
+ *
+ * @copyright © 2026, Seeed Studio
+ */
+
+#include "fb_sync.h"
+
+#include <stdatomic.h>
+#include <string.h>
+
+#include "esp_async_memcpy.h"
+#include "esp_attr.h"
+#include "esp_log.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/semphr.h"
+#include "rom/cache.h"
+
+static const char* TAG = "fb_sync";
+
+static async_memcpy_t mcp;
+static SemaphoreHandle_t done_sem;
+static atomic_int outstanding; // 未完成的 DMA 个数, 提交期间多算 1, 防止提前完成
+
+// 上一次 fb_sync_start() 的参数, fb_sync_wait() 作废缓存时用
+static bool dma_used;
+static uint8_t* last_dst;
+static fb_rect_t last_rects[FB_SYNC_MAX_RECTS];
+static int last_n;
+static int last_h_res;
+static int last_bpp;
+
+static IRAM_ATTR bool sync_done_cb(async_memcpy_t hdl, async_memcpy_event_t* event, void* args) {
+    BaseType_t high_task_awoken = pdFALSE;
+    if (atomic_fetch_sub_explicit(&outstanding, 1, memory_order_acq_rel) == 1) {
+        xSemaphoreGiveFromISR(done_sem, &high_task_awoken);
+    }
+    return high_task_awoken == pdTRUE;
+}
+
+esp_err_t fb_sync_init(void) {
+    atomic_init(&outstanding, 0);
+    done_sem = xSemaphoreCreateBinary();
+    if (done_sem == NULL) {
+        return ESP_ERR_NO_MEM;
+    }
+#if FB_SYNC_USE_DMA
+    async_memcpy_config_t config = ASYNC_MEMCPY_DEFAULT_CONFIG();
+    config.backlog = FB_SYNC_DMA_BACKLOG;
+    config.psram_trans_align = FB_SYNC_ALIGN;
+    esp_err_t ret = esp_async_memcpy_install(&config, &mcp);
+    if (ret != ESP_OK) {
+        ESP_LOGW(TAG, "Async memcpy unavailable (%s), copy with CPU", esp_err_to_name(ret));
+        mcp = NULL;
+    }
+#endif
+    return ESP_OK;
+}
+
+static int32_t rect_area(const fb_rect_t* r) {
+    return (int32_t)(r->x2 - r->x1 + 1) * (r->y2 - r->y1 + 1);
+}
+
+/* 重叠或者相邻 */
+static bool rect_touch(const fb_rect_t* a, const fb_rect_t* b) {
+    return a->x1 <= b->x2 + 1 && b->x1 <= a->x2 + 1 && a->y1 <= b->y2 + 1 && b->y1 <= a->y2 + 1;
+}
+
+int fb_sync_merge(fb_rect_t* rects, int n, int h_res, int bpp) {
+    int align_px = FB_SYNC_ALIGN % bpp == 0 ? FB_SYNC_ALIGN / bpp : 1;
+
+    for (int i = 0; i < n; i++) {
+        int x2 = (rects[i].x2 + align_px) / align_px * align_px;
+        rects[i].x1 = rects[i].x1 / align_px * align_px;
+        rects[i].x2 = (x2 < h_res ? x2 : h_res) - 1;
+    }
+
+    bool merged = true;
+    while (merged) {
+        merged = false;
+        for (int i = 0; i < n; i++) {
+            for (int j = i + 1; j < n; j++) {
+                if (!rect_touch(&rects[i], &rects[j])) {
+                    continue;
+                }
+                fb_rect_t u = {
+                    .x1 = rects[i].x1 < rects[j].x1 ? rects[i].x1 : rects[j].x1,
+                    .y1 = rects[i].y1 < rects[j].y1 ? rects[i].y1 : rects[j].y1,
+                    .x2 = rects[i].x2 > rects[j].x2 ? rects[i].x2 : rects[j].x2,
+                    .y2 = rects[i].y2 > rects[j].y2 ? rects[i].y2 : rects[j].y2,
+                };
+                // 并集比分开复制大时不合并
+                if (rect_area(&u) <= rect_area(&rects[i]) + rect_area(&rects[j])) {
+                    rects[i] = u;
+                    rects[j--] = rects[--n];
+                    merged = true;
+                }
+            }
+        }
+    }
+    return n;
+}
+
+/* 连续的一段, 能用 DMA 时返回 true */
+static bool sync_span_dma(uint8_t* dst, const uint8_t* src, size_t len) {
+    if (mcp == NULL || ((uintptr_t)dst | (uintptr_t)src | len) % FB_SYNC_ALIGN != 0) {
+        return false;
+    }
+    // DMA 直接读 PSRAM, 还在缓存里的像素要先写回
+    Cache_WriteBack_Addr((uint32_t)(uintptr_t)src, len);
+    atomic_fetch_add_explicit(&outstanding, 1, memory_order_acq_rel);
+    if (esp_async_memcpy(mcp, dst, (void*)src, len, sync_done_cb, NULL) != ESP_OK) {
+        atomic_fetch_sub_explicit(&outstanding, 1, memory_order_acq_rel);
+        return false;
+    }
+    dma_used = true;
+    return true;
+}
+
+static void sync_span(uint8_t* dst, const uint8_t* src, size_t len) {
+    if (!sync_span_dma(dst, src, len)) {
+        memcpy(dst, src, len);
+        // 面板的 DMA 直接读 PSRAM
+        Cache_WriteBack_Addr((uint32_t)(uintptr_t)dst, len);
+    }
+}
+
+void fb_sync_start(uint8_t* dst, const uint8_t* src, const fb_rect_t* rects, int n, int h_res, int bpp) {
+    size_t stride = (size_t)h_res * bpp;
+
+    if (n > FB_SYNC_MAX_RECTS) {
+        n = FB_SYNC_MAX_RECTS;
+    }
+    dma_used = false;
+    atomic_store_explicit(&outstanding, 1, memory_order_release);
+
+    for (int i = 0; i < n; i++) {
+        const fb_rect_t* r = &rects[i];
+        size_t offset = r->y1 * stride + r->x1 * bpp;
+        size_t width = (size_t)(r->x2 - r->x1 + 1) * bpp;
+        int rows = r->y2 - r->y1 + 1;
+
+        if (width == stride) {
+            // 满宽的矩形是连续的一段
+            sync_span(dst + offset, src + offset, stride * rows);
+            continue;
+        }
+        for (int y = 0; y < rows; y++, offset += stride) {
+            sync_span(dst + offset, src + offset, width);
+        }
+    }
+
+    if (dma_used) {
+        memcpy(last_rects, rects, sizeof(fb_rect_t) * n);
+        last_n = n;
+        last_dst = dst;
+        last_h_res = h_res;
+        last_bpp = bpp;
+    }
+    // 去掉提交期间多算的 1, DMA 已经全部完成时在这里结束
+    if (atomic_fetch_sub_explicit(&outstanding, 1, memory_order_acq_rel) == 1 && dma_used) {
+        xSemaphoreGive(done_sem);
+    }
+}
+
+void fb_sync_wait(void) {
+    if (!dma_used) {
+        return;
+    }
+    xSemaphoreTake(done_sem, portMAX_DELAY);
+    dma_used = false;
+
+    // 复制期间 CPU 可能读进了旧的像素; 这些 cache line 都是干净的, 作废不会丢数据
+    size_t stride = (size_t)last_h_res * last_bpp;
+    for (int i = 0; i < last_n; i++) {
+        const fb_rect_t* r = &last_rects[i];
+        size_t offset = r->y1 * stride + r->x1 * last_bpp;
+        size_t width = (size_t)(r->x2 - r->x1 + 1) * last_bpp;
+        int rows = r->y2 - r->y1 + 1;
+
+        if (width == stride) {
+            Cache_Invalidate_Addr((uint32_t)(uintptr_t)(last_dst + offset), stride * rows);
+            continue;
+        }
+        for (int y = 0; y < rows; y++, offset += stride) {
+            Cache_Invalidate_Addr((uint32_t)(uintptr_t)(last_dst + offset), width);
+        }
+    }
+}
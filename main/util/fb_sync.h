@@ -0,0 +1,75 @@
+/**
+ * @file fb_sync.h
+ * @date  16 October 2026
+
+ * @author Spencer Yan
+ *
+ * @note Copies the dirty rectangles of the displayed framebuffer to the other one in LVGL direct mode
+ *
+ * @copyright © 2026, Seeed Studio
+ */
+
+#ifndef FB_SYNC_H
+#define FB_SYNC_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "esp_err.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * direct mode 下两块帧缓冲区轮流显示, 刷新后要把这次画过的区域复制到另一块, 两块才一致.
+ *
+ * 矩形先按 FB_SYNC_ALIGN 字节对齐左右边界 (多复制的像素两块本来就相同), 再合并重叠和相邻的:
+ * 并集不大于两者面积之和时才合并, 不会多复制. 满宽的矩形在内存中是连续的一段.
+ *
+ * 复制交给 GDMA (async memcpy), CPU 不用等; 下一次 LVGL 开始画之前 fb_sync_wait() 等它完成.
+ * GDMA 不可用或描述符用完的部分由 CPU 复制. 缓存只回写/作废复制过的 cache line.
+ */
+#define FB_SYNC_MAX_RECTS (32)    // 与 LV_INV_BUF_SIZE 相同
+#define FB_SYNC_ALIGN (64)        // 字节, PSRAM DMA 的对齐要求, 也不小于 cache line
+#define FB_SYNC_DMA_BACKLOG (256) // DMA 描述符个数, 一行一个, 满宽的矩形一段几个
+#define FB_SYNC_USE_DMA (1)
+
+typedef struct {
+    int16_t x1, y1, x2, y2; // 包含边界, 与 lv_area_t 相同
+} fb_rect_t;
+
+/**
+ * @brief 安装 async memcpy, 失败时只用 CPU 复制
+ */
+esp_err_t fb_sync_init(void);
+
+/**
+ * @brief 对齐并合并矩形, 结果写回 rects
+ *
+ * @param rects 矩形, 都在 [0, h_res) x [0, v_res) 之内
+ * @param n 个数
+ * @param h_res 每行的像素数
+ * @param bpp 每个像素的字节数
+ * @return 合并后的个数
+ */
+int fb_sync_merge(fb_rect_t* rects, int n, int h_res, int bpp);
+
+/**
+ * @brief 把 src 中的矩形复制到 dst, 不等待 DMA 完成
+ * @note  上一次的复制须已 fb_sync_wait()
+ *
+ * @param rects 已经过 fb_sync_merge() 的矩形, 最多 FB_SYNC_MAX_RECTS 个
+ */
+void fb_sync_start(uint8_t* dst, const uint8_t* src, const fb_rect_t* rects, int n, int h_res, int bpp);
+
+/**
+ * @brief 等待 fb_sync_start() 的 DMA 完成, 并作废 dst 中对应的 cache line
+ */
+void fb_sync_wait(void);
+
+#ifdef __cplusplus
+} /*extern "C"*/
+#endif
+
+#endif /*FB_SYNC_H*/
@@ -0,0 +1,38 @@
+/**
+ * @file frame_arena.c
+ * @date  16 October 2026
+
+ * @author Spencer Yan
+ *
+ * @note Frame-scoped bump allocator, reset in O(1) when the frame is recycled
+ *
+ * @copyright © 2026, Seeed Studio
+ */
+
+#include "frame_arena.h"
+
+void frame_arena_init(frame_arena_t* arena, void* buf, size_t size) {
+    arena->base = (uint8_t*)buf;
+    arena->size = size;
+    arena->used = 0;
+    arena->high_water = 0;
+    arena->overflows = 0;
+    arena->overflowed = false;
+}
+
+void* frame_arena_alloc(frame_arena_t* arena, size_t size, size_t align) {
+    size_t offset = (arena->used + align - 1) & ~(align - 1);
+    if (offset + size > arena->size) {
+        if (!arena->overflowed) {
+            arena->overflowed = true;
+            arena->overflows++;
+        }
+        return NULL;
+    }
+
+    arena->used = offset + size;
+    if (arena->used > arena->high_water) {
+        arena->high_water = arena->used;
+    }
+    return arena->base + offset;
+}
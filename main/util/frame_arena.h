@@ -0,0 +1,54 @@
+/**
+ * @file frame_arena.h
+ * @date  16 October 2026
+
+ * @author Spencer Yan
+ *
+ * @note Frame-scoped bump allocator, reset in O(1) when the frame is recycled
+ *
+ * @copyright © 2026, Seeed Studio
+ */
+
+#ifndef FRAME_ARENA_H
+#define FRAME_ARENA_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief 只分配不释放, 整帧用完后 frame_arena_reset() 一次性归还
+ * @note  连续两次分配得到的内存是相邻的, 用于边解析边追加的数组
+ */
+typedef struct {
+    uint8_t* base;
+    size_t size;
+    size_t used;
+    size_t high_water;  // 历史最大用量
+    uint32_t overflows; // 空间不足的帧数
+    bool overflowed;    // 本帧是否已经空间不足
+} frame_arena_t;
+
+void frame_arena_init(frame_arena_t* arena, void* buf, size_t size);
+
+/**
+ * @brief 分配 size 字节, 按 align 对齐
+ *
+ * @return NULL 表示空间不足, 每帧第一次失败时 overflows 加一
+ */
+void* frame_arena_alloc(frame_arena_t* arena, size_t size, size_t align);
+
+static inline void frame_arena_reset(frame_arena_t* arena) {
+    arena->used = 0;
+    arena->overflowed = false;
+}
+
+#ifdef __cplusplus
+} /*extern "C"*/
+#endif
+
+#endif /*FRAME_ARENA_H*/
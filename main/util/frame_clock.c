@@ -0,0 +1,213 @@
+/**
+ * @file frame_clock.c
+ * @date  16 October 2026
+
+ * @author Spencer Yan
+ *
+ * @note Presents camera frames on vsync slots of the RGB panel at a steady cadence, with a target fps
+ *
+ * @copyright © 2026, Seeed Studio
+ */
+
+#include "frame_clock.h"
+
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "bsp_lcd.h"
+#include "esp_console.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+
+static const char* TAG = "frame_clock";
+
+#define EWMA_SHIFT (3) // 新样本占 1/8
+
+// 控制台写, 界面任务读
+static volatile uint32_t target_fps;
+static volatile bool stats_reset;
+
+// 以下只在界面任务中访问
+static int64_t panel_period_us; // 0 表示还没有测到 vsync
+static uint32_t panel_last_count;
+static int64_t panel_last_time;
+static int64_t arrival_period_us;
+static int64_t arrival_last;
+static uint32_t hold;
+static bool slot_valid;
+static uint32_t last_slot; // 上一帧上屏时的 vsync 计数
+static int64_t last_present;
+
+// 统计, 控制台读
+static uint32_t stats_vsync_from;
+static int64_t stats_time_from;
+static uint32_t stats_presented;
+static uint32_t stats_late;   // 来晚的帧
+static uint32_t stats_missed; // 来晚的帧错过的槽位数
+static uint32_t stats_behind; // 流水线积压, 少等一次刷新的帧
+
+static int64_t ewma(int64_t avg, int64_t sample) {
+    return avg == 0 ? sample : avg + ((sample - avg) >> EWMA_SHIFT);
+}
+
+static void clock_update_panel(uint32_t count, int64_t time) {
+    if (time == 0) {
+        return;
+    }
+    if (panel_last_time != 0 && count != panel_last_count) {
+        panel_period_us = ewma(panel_period_us, (time - panel_last_time) / (count - panel_last_count));
+    }
+    panel_last_count = count;
+    panel_last_time = time;
+}
+
+/* 返回 false 表示暂停过, 从这一帧重新对齐 */
+static bool clock_update_arrival(int64_t arrival) {
+    int64_t gap = arrival - arrival_last;
+    arrival_last = arrival;
+    if (gap <= 0 || gap > FRAME_CLOCK_ARRIVAL_MAX_US) {
+        return false;
+    }
+    arrival_period_us = ewma(arrival_period_us, gap);
+    return true;
+}
+
+static uint32_t clock_hold(void) {
+    uint32_t fps = target_fps;
+    int64_t n = 1;
+
+    if (fps > 0) {
+        int64_t target_us = 1000000 / fps;
+        n = (target_us + panel_period_us - 1) / panel_period_us;
+    }
+    int64_t follow = (arrival_period_us + panel_period_us / 2) / panel_period_us;
+    if (follow > n) {
+        n = follow;
+    }
+    return n < 1 ? 1 : (n > FRAME_CLOCK_MAX_HOLD ? FRAME_CLOCK_MAX_HOLD : (uint32_t)n);
+}
+
+static void clock_reset_stats(uint32_t count) {
+    stats_vsync_from = count;
+    stats_time_from = esp_timer_get_time();
+    stats_presented = 0;
+    stats_late = 0;
+    stats_missed = 0;
+    stats_behind = 0;
+}
+
+void frame_clock_pace(const view_frame_t* frame) {
+    int64_t vsync_time;
+    uint32_t count = bsp_lcd_get_vsync_count(&vsync_time);
+
+    if (stats_reset) {
+        stats_reset = false;
+        clock_reset_stats(count);
+    }
+    clock_update_panel(count, vsync_time);
+    int64_t arrival = frame->ts[VIEW_FRAME_TS_RX] != 0 ? frame->ts[VIEW_FRAME_TS_RX] : esp_timer_get_time();
+    if (!clock_update_arrival(arrival)) {
+        slot_valid = false;
+    }
+    stats_presented++;
+    if (panel_period_us == 0) {
+        return;
+    }
+
+    hold = clock_hold();
+    uint32_t n = hold;
+    // 上一帧上屏前这一帧已经解码好了, 说明在排队
+    if (slot_valid && n > 1 && frame->ts[VIEW_FRAME_TS_DECODED] != 0 &&
+        frame->ts[VIEW_FRAME_TS_DECODED] < last_present) {
+        n--;
+        stats_behind++;
+    }
+
+    uint32_t slot = last_slot + n;
+    int32_t late = (int32_t)(count - slot);
+    if (!slot_valid || late >= 0) {
+        if (slot_valid && late > 0) {
+            stats_late++;
+            stats_missed += late;
+        }
+        slot = count;
+    } else {
+        uint32_t timeout_ms = (uint32_t)((int64_t)n * panel_period_us / 1000) * 2 + 10;
+        if (bsp_lcd_wait_vsync(slot, timeout_ms) != ESP_OK) {
+            // 面板停了, 不再对齐
+            slot = bsp_lcd_get_vsync_count(NULL);
+            panel_period_us = 0;
+            panel_last_time = 0;
+        }
+    }
+
+    last_slot = slot;
+    last_present = esp_timer_get_time();
+    slot_valid = true;
+}
+
+void frame_clock_set_fps(uint32_t fps) {
+    target_fps = fps;
+}
+
+void frame_clock_dump(void) {
+    int64_t now = esp_timer_get_time();
+    uint32_t vsyncs = bsp_lcd_get_vsync_count(NULL) - stats_vsync_from;
+    int64_t elapsed = now - stats_time_from;
+    uint32_t presented = stats_presented;
+
+    if (elapsed <= 0 || presented == 0) {
+        printf("no frames presented\n");
+        return;
+    }
+    printf("target %lu fps, hold %lu refreshes\n", (unsigned long)target_fps, (unsigned long)hold);
+    printf("panel  %6.2f Hz (%6.2f ms)\n", vsyncs * 1e6 / elapsed, panel_period_us / 1000.0);
+    printf("frames %6.2f fps arriving (%6.2f ms), %6.2f fps presented\n",
+           arrival_period_us > 0 ? 1e6 / arrival_period_us : 0.0, arrival_period_us / 1000.0,
+           presented * 1e6 / elapsed);
+    printf("%lu late (%lu slots missed), %lu behind, %lu refreshes without a new frame\n",
+           (unsigned long)stats_late, (unsigned long)stats_missed, (unsigned long)stats_behind,
+           (unsigned long)(vsyncs > presented ? vsyncs - presented : 0));
+}
+
+static int fps_cmd(int argc, char** argv) {
+    if (argc > 1 && strcmp(argv[1], "reset") == 0) {
+        stats_reset = true;
+        printf("fps reset\n");
+        return 0;
+    }
+    if (argc > 1) {
+        char* end;
+        long fps = strtol(argv[1], &end, 10);
+        if (*end != '\0' || fps < 0) {
+            printf("invalid fps: %s\n", argv[1]);
+            return 1;
+        }
+        frame_clock_set_fps((uint32_t)fps);
+        stats_reset = true;
+        printf("target %ld fps\n", fps);
+        return 0;
+    }
+    frame_clock_dump();
+    return 0;
+}
+
+esp_err_t frame_clock_init(uint32_t fps) {
+    target_fps = fps;
+    clock_reset_stats(bsp_lcd_get_vsync_count(NULL));
+
+    const esp_console_cmd_t cmd = {
+        .command = "fps",
+        .help = "Print panel and frame rates, 'fps N' to cap presented frames (0 follows the camera), "
+                "'fps reset' to start over",
+        .hint = "[N|reset]",
+        .func = fps_cmd,
+    };
+    esp_err_t ret = esp_console_cmd_register(&cmd);
+    if (ret != ESP_OK) {
+        ESP_LOGW(TAG, "Failed to register console command");
+    }
+    return ret;
+}
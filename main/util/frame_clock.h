@@ -0,0 +1,63 @@
+/**
+ * @file frame_clock.h
+ * @date  16 October 2026
+
+ * @author Spencer Yan
+ *
+ * @note Presents camera frames on vsync slots of the RGB panel at a steady cadence, with a target fps
+ *
+ * @copyright © 2026, Seeed Studio
+ */
+
+#ifndef FRAME_CLOCK_H
+#define FRAME_CLOCK_H
+
+#include <stdint.h>
+
+#include "esp_err.h"
+#include "view_frame.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * 面板由 lcd_task 连续刷新 (RGB 屏没有 GRAM, 不能停), 每次刷新结束产生一个 vsync.
+ * 推理帧率和面板刷新率不成整数倍时, 每帧在屏上停留的刷新次数忽多忽少, 看起来一顿一顿的.
+ *
+ * 这里把每帧的上屏时刻对齐到 vsync 槽位: 相邻两帧间隔 hold 次刷新,
+ *   hold = max(目标帧间隔 / 刷新间隔 向上取整, 到达间隔 / 刷新间隔 四舍五入, 1)
+ * 刷新间隔和到达间隔都是滑动平均. 帧来晚了就立即上屏并计入 missed, 从这一帧重新对齐;
+ * 前一帧上屏时这一帧已经在排队 (流水线积压) 时少等一次刷新, 延迟不会越积越多.
+ */
+#define FRAME_CLOCK_MAX_HOLD (15)          // 低于约 4 fps 时不再对齐
+#define FRAME_CLOCK_ARRIVAL_MAX_US (500000) // 更长的间隔当作暂停, 不计入平均
+
+/**
+ * @brief 注册控制台命令 "fps", 须在 app_main 创建控制台之后调用
+ *
+ * @param target_fps 最高上屏帧率, 0 表示跟随到达的帧率
+ */
+esp_err_t frame_clock_init(uint32_t target_fps);
+
+/**
+ * @brief 修改最高上屏帧率, 可以在任意任务中调用
+ */
+void frame_clock_set_fps(uint32_t target_fps);
+
+/**
+ * @brief 等到这一帧的 vsync 槽位, 在界面任务中画这一帧之前调用, 不能持有 lv_port_sem
+ * @note  面板没有 vsync (不是 RGB 屏) 时立即返回
+ */
+void frame_clock_pace(const view_frame_t* frame);
+
+/**
+ * @brief 打印刷新率, 上屏帧率和错过的槽位
+ */
+void frame_clock_dump(void);
+
+#ifdef __cplusplus
+} /*extern "C"*/
+#endif
+
+#endif /*FRAME_CLOCK_H*/
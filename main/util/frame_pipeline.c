@@ -0,0 +1,266 @@
+/**
+ * @file frame_pipeline.c
+ * @date  16 October 2026
+
+ * @author Spencer Yan
+ *
+ * @note Parse, decode and render stages of the frame pipeline, without tasks or queues
+ *
+ * @copyright © 2026, Seeed Studio
+ */
+
+#include "frame_pipeline.h"
+#include <string.h>
+#include "app_boxes.h"
+#include "app_image.h"
+#include "app_keypoints.h"
+#include "esp_log.h"
+#include "pixel_ops.h"
+#include "rp2040_rx.h"
+#include "sscma_parser.h"
+
+static const char* TAG = "frame_pipeline";
+
+static frame_pipeline_post_t post_cb;
+static view_frame_t* pending_frame; // JSON 模式下图像和检测结果分两行到达, 先收到的图像暂存在这里
+
+static void log_truncated(void) {
+    size_t high_water, size;
+    uint32_t overflows;
+    view_frame_arena_stats(&high_water, &size, &overflows);
+    ESP_LOGW(TAG, "Too many results in one frame, the rest are dropped (keypoint arena high water %u/%u bytes, %lu overflows)",
+             (unsigned)high_water, (unsigned)size, (unsigned long)overflows);
+}
+
+/* 解析完成, 交给下一级 */
+static void post_view_frame(view_frame_t* frame) {
+    view_frame_stamp(frame, VIEW_FRAME_TS_PARSED);
+    post_cb(frame);
+}
+
+/* 上一张图像没有等到检测结果, 单独显示 */
+static void flush_pending_frame(void) {
+    if (pending_frame != NULL) {
+        post_view_frame(pending_frame);
+        pending_frame = NULL;
+    }
+}
+
+/* JSON 模式: 图像先到, 等待下一行检测结果 */
+static void process_image(frame_buf_t* img, int64_t t_rx) {
+    flush_pending_frame();
+
+    pending_frame = view_frame_alloc();
+    if (pending_frame == NULL) {
+        ESP_LOGW(TAG, "View is busy, drop image");
+        frame_buf_unref(img);
+        return;
+    }
+    pending_frame->img = img;
+    view_frame_stamp_rx(pending_frame, t_rx);
+    pending_frame->ts[VIEW_FRAME_TS_B64] = t_rx; // 接收时已经边收边解完
+}
+
+/* 处理一行 JSON: 与暂存的图像合成一帧 */
+static void process_json_data(char* str, int64_t t_rx) {
+    view_frame_t* frame = pending_frame ? pending_frame : view_frame_alloc();
+    if (frame == NULL) {
+        ESP_LOGW(TAG, "View is busy, drop results");
+        return;
+    }
+    pending_frame = NULL;
+    view_frame_stamp_rx(frame, t_rx);
+
+    sscma_result_t* result = &frame->result;
+    if (!sscma_parse(str, strlen(str), result)) {
+        ESP_LOGE(TAG, "Invalid JSON string: %s", str);
+        sscma_result_clear(result);
+    }
+
+    /* RP2040 确认帧格式切换 */
+    if (result->fields & SSCMA_FIELD_FRAME_MODE) {
+        ESP_LOGI(TAG, "RP2040 frame mode: %d", result->frame_mode);
+    }
+
+    /* 处理图像数据: 通常已经在接收时被提取出来, 这里只处理仍留在行内的情况 */
+    if ((result->fields & SSCMA_FIELD_IMG) && result->img_len > 0 && frame->img == NULL) {
+        frame->img = frame_buf_alloc();
+        if (frame->img == NULL) {
+            ESP_LOGW(TAG, "No free frame buffer, drop image");
+        } else {
+            // 解析已经完成, 用结尾的引号位置放 '\0', 行缓冲区属于本任务
+            str[(result->img - str) + result->img_len] = '\0';
+            frame->img->len = decode_base64_image((const unsigned char*)result->img, frame->img->data,
+                                                  frame->img->size);
+            if (frame->img->len == 0) {
+                ESP_LOGE(TAG, "Failed to decode image");
+                frame_buf_unref(frame->img);
+                frame->img = NULL;
+            }
+        }
+        view_frame_stamp(frame, VIEW_FRAME_TS_B64);
+    }
+    result->img = NULL; // 行缓冲区处理完就归还
+
+    if (frame->ts[VIEW_FRAME_TS_B64] == 0) {
+        frame->ts[VIEW_FRAME_TS_B64] = frame->ts[VIEW_FRAME_TS_RX];
+    }
+
+    if (result->truncated) {
+        log_truncated();
+    }
+
+    /* 没有检测结果的行 (例如 frame_mode 确认) 不结束当前帧 */
+    const uint32_t result_fields = SSCMA_FIELD_BOXES | SSCMA_FIELD_CLASSES | SSCMA_FIELD_POINTS | SSCMA_FIELD_KEYPOINTS;
+    if (!(result->fields & result_fields)) {
+        if (frame->img != NULL) {
+            pending_frame = frame;
+        } else {
+            view_frame_free(frame);
+        }
+        return;
+    }
+
+    post_view_frame(frame);
+}
+
+/* 处理二进制帧: 图像和检测结果在同一帧中 */
+static void process_bin_frame(const uint8_t* data, int64_t t_rx) {
+    flush_pending_frame();
+
+    view_frame_t* frame = view_frame_alloc();
+    if (frame == NULL) {
+        ESP_LOGW(TAG, "View is busy, drop frame");
+        return;
+    }
+    view_frame_stamp_rx(frame, t_rx);
+
+    sscma_result_t* result = &frame->result;
+    if (!sscma_parse_bin(data, result)) {
+        ESP_LOGE(TAG, "Truncated section in binary frame");
+    }
+
+    // 二进制帧所在的接收缓冲区会被复用, 图像需要拷贝出来
+    if (result->jpeg_len > 0) {
+        frame->img = frame_buf_alloc();
+        if (frame->img == NULL) {
+            ESP_LOGW(TAG, "No free frame buffer, drop image");
+        } else if (result->jpeg_len > frame->img->size) {
+            ESP_LOGE(TAG, "Invalid JPEG section size: %d", (int)result->jpeg_len);
+            frame_buf_unref(frame->img);
+            frame->img = NULL;
+        } else {
+            memcpy(frame->img->data, result->jpeg, result->jpeg_len);
+            frame->img->len = result->jpeg_len;
+        }
+        result->jpeg = NULL;
+    }
+    view_frame_stamp(frame, VIEW_FRAME_TS_B64); // 二进制帧没有 base64, 这里是拷贝完成
+
+    if (result->truncated) {
+        log_truncated();
+    }
+
+    post_view_frame(frame);
+}
+
+void frame_pipeline_init(frame_pipeline_post_t post) {
+    post_cb = post;
+    pending_frame = NULL;
+}
+
+void frame_pipeline_parse(const rp2040_msg_t* msg) {
+    if (msg->data == NULL) {
+        return;
+    }
+    switch (msg->type) {
+    case RP2040_MSG_IMAGE:
+        process_image((frame_buf_t*)msg->data, msg->t_rx);
+        break;
+    case RP2040_MSG_BIN_FRAME:
+        process_bin_frame((const uint8_t*)msg->data, msg->t_rx);
+        break;
+    case RP2040_MSG_JSON:
+        process_json_data((char*)msg->data, msg->t_rx);
+        break;
+    }
+    rp2040_rx_release(msg);
+}
+
+bool frame_pipeline_decode(view_frame_t* frame, uint8_t* buf) {
+    lv_area_t area;
+    if (frame->img == NULL ||
+        !decode_jpeg_to_buffer(frame->img->data, frame->img->len, (lv_color_t*)buf, CANVAS_WIDTH, CANVAS_HEIGHT,
+                               &area, &frame->canvas_scale)) {
+        return false;
+    }
+    frame->canvas_buf = buf;
+    frame->canvas_w = lv_area_get_width(&area);
+    frame->canvas_h = lv_area_get_height(&area);
+    return true;
+}
+
+/* 检测结果的坐标在原图上, 按画布上的缩放比例换算; 关键点在本帧的 arena 中, 可以直接改 */
+static void scale_result(sscma_result_t* result, uint8_t scale) {
+    if (scale == 0) {
+        return;
+    }
+    for (int i = 0; i < result->boxes_count; i++) {
+        for (int j = 0; j < 4; j++) {
+            result->boxes[i].boxArray[j] >>= scale;
+        }
+    }
+    for (int i = 0; i < result->keypoints_count; i++) {
+        keypoints_t* kp = &result->keypoints[i];
+        for (int j = 0; j < 4; j++) {
+            kp->box.boxArray[j] >>= scale;
+        }
+        for (size_t j = 0; j < kp->points_count; j++) {
+            kp->points[j].x >>= scale;
+            kp->points[j].y >>= scale;
+        }
+    }
+}
+
+uint8_t* frame_pipeline_render(view_frame_t* frame, lv_obj_t* canvas_left, lv_obj_t* canvas_right) {
+    static int right_canvs_delay = 0;
+    static bool is_right_canvas_cleaned = 0;
+    static bool has_images = false;
+    static uint8_t canvas_scale = 0; // 最近一张图像的缩放, 没有图像的结果也按它画
+
+    sscma_result_t* result = &frame->result;
+    uint8_t* old = NULL;
+
+    // 有图像流时, 没有图像的结果对不上画布上的画面, 只画在右侧
+    has_images |= frame->img != NULL;
+    bool draw_left = frame->img != NULL || !has_images;
+
+    if (frame->canvas_buf != NULL) {
+        old = (uint8_t*)lv_canvas_get_img(canvas_left)->data;
+        lv_canvas_set_buffer(canvas_left, frame->canvas_buf, CANVAS_WIDTH, CANVAS_HEIGHT, LV_IMG_CF_TRUE_COLOR);
+        frame->canvas_buf = NULL;
+        canvas_scale = frame->canvas_scale;
+    }
+    scale_result(result, canvas_scale);
+
+    if (draw_left) {
+        for (int i = 0; i < result->boxes_count; i++) {
+            draw_one_box(canvas_left, result->boxes[i], lv_color_make(113, 235, 52));
+        }
+    }
+
+    if (result->keypoints_count > 0) {
+        right_canvs_delay = 0;
+        is_right_canvas_cleaned = false;
+        pixel_canvas_fill(canvas_right, lv_palette_main(LV_PALETTE_NONE));
+
+        if (draw_left) {
+            draw_keypoints_array(canvas_left, result->keypoints, result->keypoints_count);
+        }
+        draw_keypoints_array(canvas_right, result->keypoints, result->keypoints_count);
+    } else if (frame->img != NULL && !is_right_canvas_cleaned && ++right_canvs_delay >= 2) {
+        is_right_canvas_cleaned = true;
+        pixel_canvas_fill(canvas_right, lv_palette_main(LV_PALETTE_NONE));
+    }
+    return old;
+}
@@ -0,0 +1,73 @@
+/**
+ * @file frame_pipeline.h
+ * @date  16 October 2026
+
+ * @author Spencer Yan
+ *
+ * @note Parse, decode and render stages of the frame pipeline, without tasks or queues
+ *
+ * @copyright © 2026, Seeed Studio
+ */
+
+#ifndef FRAME_PIPELINE_H
+#define FRAME_PIPELINE_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "esp32_rp2040.h"
+#include "lvgl.h"
+#include "view_frame.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * 每一级都是普通函数, 任务, 队列和锁由调用者决定: 固件中见 main.c,
+ * 主机上的回放工具见 tools/replay.
+ */
+
+/**
+ * @brief 解析完成的帧的出口, 接收方负责 view_frame_free()
+ */
+typedef void (*frame_pipeline_post_t)(view_frame_t* frame);
+
+/**
+ * @brief 设置解析阶段的出口, 丢弃暂存的图像
+ */
+void frame_pipeline_init(frame_pipeline_post_t post);
+
+/**
+ * @brief 解析阶段: 把 RP2040 的消息合成 view_frame_t
+ * @note  JSON 模式下图像先到, 会暂存到检测结果那一行到达; 返回前归还 msg 的接收缓冲区
+ *
+ * @param msg rp2040_rx 送出的消息
+ */
+void frame_pipeline_parse(const rp2040_msg_t* msg);
+
+/**
+ * @brief 解码阶段: 把 frame 的 JPEG 解码到 buf, 不访问 LVGL 对象
+ *
+ * @param frame 解析阶段送出的帧
+ * @param buf CANVAS_WIDTH x CANVAS_HEIGHT 的 LV_IMG_CF_TRUE_COLOR 缓冲区
+ * @return true 表示 buf 已挂到 frame->canvas_buf, false 表示没有用到 buf
+ */
+bool frame_pipeline_decode(view_frame_t* frame, uint8_t* buf);
+
+/**
+ * @brief 显示阶段: 换上解码好的缓冲区, 画检测框和关键点
+ * @note  须持有 lv_port_sem
+ *
+ * @param frame 解码阶段送出的帧
+ * @param canvas_left 图像和叠加层
+ * @param canvas_right 只画关键点
+ * @return 换下来的左侧画布缓冲区, 没有换时为 NULL
+ */
+uint8_t* frame_pipeline_render(view_frame_t* frame, lv_obj_t* canvas_left, lv_obj_t* canvas_right);
+
+#ifdef __cplusplus
+} /*extern "C"*/
+#endif
+
+#endif /*FRAME_PIPELINE_H*/
@@ -0,0 +1,88 @@
+/**
+ * @file frame_pool.c
+ * @date  16 October 2026
+
+ * @author Spencer Yan
+ *
+ * @note Reference-counted image buffers handed from the parser to the view handlers
+ *
+ * @copyright © 2026, Seeed Studio
+ */
+
+#include "frame_pool.h"
+#include <stdbool.h>
+#include "esp_heap_caps.h"
+#include "esp_log.h"
+
+static const char* TAG = "frame_pool";
+
+static frame_buf_t frame_pool[FRAME_POOL_SIZE];
+static atomic_size_t pool_buf_size;
+
+esp_err_t frame_pool_init(size_t buf_size) {
+    atomic_init(&pool_buf_size, buf_size);
+    for (int i = 0; i < FRAME_POOL_SIZE; i++) {
+        frame_pool[i].data = (uint8_t*)heap_caps_malloc(buf_size, MALLOC_CAP_SPIRAM);
+        if (frame_pool[i].data == NULL) {
+            ESP_LOGE(TAG, "Failed to allocate frame buffer %d", i);
+            return ESP_ERR_NO_MEM;
+        }
+        frame_pool[i].size = buf_size;
+        frame_pool[i].len = 0;
+        atomic_init(&frame_pool[i].refcnt, 0);
+    }
+    return ESP_OK;
+}
+
+void frame_pool_set_buf_size(size_t buf_size) {
+    atomic_store(&pool_buf_size, buf_size);
+}
+
+/* buf 已经被调用者取出, 按当前容量换一块内存; 先分配再释放, 失败时 buf 保持原样 */
+static bool frame_buf_resize(frame_buf_t* buf, size_t buf_size) {
+    uint8_t* data = (uint8_t*)heap_caps_malloc(buf_size, MALLOC_CAP_SPIRAM);
+    if (data == NULL) {
+        ESP_LOGE(TAG, "Failed to resize frame buffer to %u bytes", (unsigned)buf_size);
+        return false;
+    }
+    heap_caps_free(buf->data);
+    buf->data = data;
+    buf->size = buf_size;
+    return true;
+}
+
+frame_buf_t* frame_buf_alloc(void) {
+    for (int i = 0; i < FRAME_POOL_SIZE; i++) {
+        int expected = 0;
+        if (atomic_compare_exchange_strong(&frame_pool[i].refcnt, &expected, 1)) {
+            frame_buf_t* buf = &frame_pool[i];
+            size_t buf_size = atomic_load(&pool_buf_size);
+            if (buf->size != buf_size && !frame_buf_resize(buf, buf_size) && buf->size < buf_size) {
+                // 旧的缓冲区装不下新分辨率的图像
+                atomic_store(&buf->refcnt, 0);
+                return NULL;
+            }
+            buf->len = 0;
+            return buf;
+        }
+    }
+    return NULL;
+}
+
+frame_buf_t* frame_buf_ref(frame_buf_t* buf) {
+    if (buf) {
+        atomic_fetch_add(&buf->refcnt, 1);
+    }
+    return buf;
+}
+
+void frame_buf_unref(frame_buf_t* buf) {
+    if (buf == NULL) {
+        return;
+    }
+    int prev = atomic_fetch_sub(&buf->refcnt, 1);
+    if (prev <= 0) {
+        ESP_LOGE(TAG, "Unbalanced unref on frame buffer %p", buf);
+        atomic_store(&buf->refcnt, 0);
+    }
+}
@@ -0,0 +1,67 @@
+/**
+ * @file frame_pool.h
+ * @date  16 October 2026
+
+ * @author Spencer Yan
+ *
+ * @note Reference-counted image buffers handed from the parser to the view handlers
+ *
+ * @copyright © 2026, Seeed Studio
+ */
+
+#ifndef FRAME_POOL_H
+#define FRAME_POOL_H
+
+#include <stdatomic.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "esp_err.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define FRAME_POOL_SIZE (4)
+
+/**
+ * @brief 一帧图像的缓冲区
+ * @note  事件里只传递指针，持有者用完后调用 frame_buf_unref() 归还
+ */
+typedef struct {
+    uint8_t* data;     // 解码后的 JPEG 数据
+    size_t size;       // data 的容量
+    size_t len;        // data 中有效字节数
+    atomic_int refcnt; // 0 表示空闲
+} frame_buf_t;
+
+/**
+ * @brief 从 PSRAM 分配 FRAME_POOL_SIZE 个缓冲区
+ *
+ * @param buf_size 每个缓冲区的容量
+ */
+esp_err_t frame_pool_init(size_t buf_size);
+
+/**
+ * @brief 改变缓冲区容量, 例如图像分辨率改变之后
+ * @note  正在使用的缓冲区不受影响, 每个缓冲区在下一次被 frame_buf_alloc() 取出时重新分配
+ *
+ * @param buf_size 新的容量
+ */
+void frame_pool_set_buf_size(size_t buf_size);
+
+/**
+ * @brief 取一个空闲缓冲区，引用计数为 1
+ *
+ * @return NULL 表示所有缓冲区都被占用（消费者跟不上）, 或者按新容量重新分配失败
+ */
+frame_buf_t* frame_buf_alloc(void);
+
+frame_buf_t* frame_buf_ref(frame_buf_t* buf);
+void frame_buf_unref(frame_buf_t* buf);
+
+#ifdef __cplusplus
+} /*extern "C"*/
+#endif
+
+#endif /*FRAME_POOL_H*/
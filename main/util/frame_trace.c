@@ -0,0 +1,256 @@
+/**
+ * @file frame_trace.c
+ * @date  16 October 2026
+
+ * @author Spencer Yan
+ *
+ * @note Per-frame latency trace from UART receive to LCD scan-out, dumped as histograms on the console
+ *
+ * @copyright © 2026, Seeed Studio
+ */
+
+#include "frame_trace.h"
+
+#include <stdatomic.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "bsp_lcd.h"
+#include "esp_attr.h"
+#include "esp_console.h"
+#include "esp_log.h"
+#include "rp2040_rx.h"
+
+static const char* TAG = "frame_trace";
+
+#define RING_MASK (FRAME_TRACE_RING_SIZE - 1)
+#define HIST_BUCKETS (10) // <1 <2 <4 ... <256 >=256 ms
+
+#if (FRAME_TRACE_RING_SIZE & RING_MASK) != 0
+#error "FRAME_TRACE_RING_SIZE must be a power of 2"
+#endif
+
+/**
+ * 交接顺序: 界面任务 -> pending -> disp_flush (lvgl_task) -> in_flight -> vsync 中断 -> ring
+ *
+ * pending 由 lv_port_sem 保护; in_flight 由 in_flight_ready 交接, 同一时间只有一方在写;
+ * ring 只有 vsync 中断写, 控制台读, 读完后根据 ring_head 丢弃期间被覆盖的记录.
+ */
+static frame_trace_t pending;
+static bool pending_valid;
+static uint32_t merged; // 和后一帧在同一次刷新里上屏
+
+static DRAM_ATTR frame_trace_t in_flight;
+static DRAM_ATTR atomic_bool in_flight_ready;
+
+static DRAM_ATTR frame_trace_t ring[FRAME_TRACE_RING_SIZE];
+static DRAM_ATTR atomic_uint ring_head; // 写入的总条数
+static unsigned int dump_from;          // "trace reset" 之后的第一条
+
+typedef struct {
+    const char* name;
+    view_frame_ts_t from;
+    view_frame_ts_t to;
+} trace_segment_t;
+
+static const trace_segment_t segments[] = {
+    {"base64", VIEW_FRAME_TS_RX, VIEW_FRAME_TS_B64},
+    {"parse", VIEW_FRAME_TS_B64, VIEW_FRAME_TS_PARSED},
+    {"jpeg", VIEW_FRAME_TS_PARSED, VIEW_FRAME_TS_DECODED}, // 含排队
+    {"overlay", VIEW_FRAME_TS_DECODED, VIEW_FRAME_TS_RENDERED},
+    {"flush", VIEW_FRAME_TS_RENDERED, VIEW_FRAME_TS_FLUSH},
+    {"vsync", VIEW_FRAME_TS_FLUSH, VIEW_FRAME_TS_VSYNC},
+    {"total", VIEW_FRAME_TS_RX, VIEW_FRAME_TS_VSYNC},
+};
+
+static IRAM_ATTR bool frame_trace_on_vsync(void* data) {
+    (void)data;
+    if (!atomic_load_explicit(&in_flight_ready, memory_order_acquire)) {
+        return false;
+    }
+
+    unsigned int head = atomic_load_explicit(&ring_head, memory_order_relaxed);
+    in_flight.ts[VIEW_FRAME_TS_VSYNC] = esp_timer_get_time();
+    ring[head & RING_MASK] = in_flight;
+    atomic_store_explicit(&ring_head, head + 1, memory_order_release);
+    atomic_store_explicit(&in_flight_ready, false, memory_order_release);
+    return false;
+}
+
+void frame_trace_rendered(const view_frame_t* frame) {
+    if (pending_valid) {
+        merged++;
+    }
+    pending.has_seq = (frame->result.fields & SSCMA_FIELD_SEQ) != 0;
+    pending.seq = (uint16_t)frame->result.seq;
+    pending.has_perf = (frame->result.fields & SSCMA_FIELD_PERF) != 0;
+    pending.perf = frame->result.perf;
+    memcpy(pending.ts, frame->ts, sizeof(pending.ts));
+    pending_valid = true;
+}
+
+void frame_trace_flush(void) {
+    // 上一帧还没等到 vsync 时, 留到下一次刷新
+    if (!pending_valid || atomic_load_explicit(&in_flight_ready, memory_order_acquire)) {
+        return;
+    }
+
+    in_flight = pending;
+    in_flight.ts[VIEW_FRAME_TS_FLUSH] = esp_timer_get_time();
+    pending_valid = false;
+    atomic_store_explicit(&in_flight_ready, true, memory_order_release);
+}
+
+static int compare_int32(const void* a, const void* b) {
+    int32_t x = *(const int32_t*)a;
+    int32_t y = *(const int32_t*)b;
+    return (x > y) - (x < y);
+}
+
+static int hist_bucket(int32_t us) {
+    int bucket = 0;
+    for (int32_t limit = 1000; bucket < HIST_BUCKETS - 1 && us >= limit; limit *= 2) {
+        bucket++;
+    }
+    return bucket;
+}
+
+/* 一行直方图, values 会被排序 */
+static void print_histogram(const char* name, int32_t* values, int n) {
+    if (n == 0) {
+        printf("  %-8s %s\n", name, "-");
+        return;
+    }
+
+    int hist[HIST_BUCKETS] = {0};
+    for (int i = 0; i < n; i++) {
+        hist[hist_bucket(values[i])]++;
+    }
+    qsort(values, n, sizeof(int32_t), compare_int32);
+
+    printf("  %-8s", name);
+    for (int i = 0; i < HIST_BUCKETS; i++) {
+        printf(" %5d", hist[i]);
+    }
+    printf(" %8.2f %8.2f %8.2f\n", values[n / 2] / 1000.0, values[(n * 99) / 100] / 1000.0, values[n - 1] / 1000.0);
+}
+
+void frame_trace_dump(void) {
+    frame_trace_t* snap = malloc(sizeof(frame_trace_t) * FRAME_TRACE_RING_SIZE);
+    int32_t* values = malloc(sizeof(int32_t) * FRAME_TRACE_RING_SIZE);
+    if (snap == NULL || values == NULL) {
+        ESP_LOGE(TAG, "No memory for trace dump");
+        free(snap);
+        free(values);
+        return;
+    }
+
+    unsigned int head = atomic_load_explicit(&ring_head, memory_order_acquire);
+    unsigned int start = head - dump_from > FRAME_TRACE_RING_SIZE ? head - FRAME_TRACE_RING_SIZE : dump_from;
+    int n = 0;
+    for (unsigned int i = start; i != head; i++) {
+        snap[n++] = ring[i & RING_MASK];
+    }
+
+    // 复制期间被 vsync 中断覆盖的记录不可信
+    unsigned int head_after = atomic_load_explicit(&ring_head, memory_order_acquire);
+    int skip = 0;
+    while (skip < n && head_after - (start + skip) >= FRAME_TRACE_RING_SIZE) {
+        skip++;
+    }
+    n -= skip;
+    memmove(snap, snap + skip, sizeof(frame_trace_t) * n);
+
+    if (n == 0) {
+        printf("no frames traced\n");
+        free(snap);
+        free(values);
+        return;
+    }
+
+    // RP2040 发出但没有在屏幕上单独出现的帧
+    uint32_t missing = 0;
+    for (int i = 1; i < n; i++) {
+        if (snap[i].has_seq && snap[i - 1].has_seq) {
+            uint16_t gap = snap[i].seq - snap[i - 1].seq;
+            if (gap > 1 && gap < 0x8000) {
+                missing += gap - 1;
+            }
+        }
+    }
+
+    printf("%d frames (seq %u..%u), %lu missing seq, %lu merged into a later refresh\n", n, snap[0].seq,
+           snap[n - 1].seq, (unsigned long)missing, (unsigned long)merged);
+    rp2040_rx_stats_t rx_stats;
+    rp2040_rx_get_stats(&rx_stats);
+    printf("rx: %lu received, %lu dropped, %lu overwritten, %lu errors\n", (unsigned long)rx_stats.received,
+           (unsigned long)rx_stats.dropped, (unsigned long)rx_stats.overwritten, (unsigned long)rx_stats.errors);
+    printf("  %-8s", "ms");
+    for (int i = 0, limit = 1; i < HIST_BUCKETS; i++, limit *= 2) {
+        if (i < HIST_BUCKETS - 1) {
+            printf("  <%-3d", limit);
+        } else {
+            printf(" >=%-3d", limit / 2);
+        }
+    }
+    printf(" %8s %8s %8s\n", "p50", "p99", "max");
+
+    int count = 0;
+    for (int i = 0; i < n; i++) {
+        if (snap[i].has_perf) {
+            const perf_t* perf = &snap[i].perf;
+            values[count++] = (perf->prepocess + perf->inference + perf->postprocess) * 1000;
+        }
+    }
+    print_histogram("model", values, count);
+
+    for (size_t s = 0; s < sizeof(segments) / sizeof(segments[0]); s++) {
+        count = 0;
+        for (int i = 0; i < n; i++) {
+            int64_t from = snap[i].ts[segments[s].from];
+            int64_t to = snap[i].ts[segments[s].to];
+            if (from != 0 && to >= from) {
+                values[count++] = (int32_t)(to - from);
+            }
+        }
+        print_histogram(segments[s].name, values, count);
+    }
+
+    free(snap);
+    free(values);
+}
+
+static int trace_cmd(int argc, char** argv) {
+    if (argc > 1 && strcmp(argv[1], "reset") == 0) {
+        dump_from = atomic_load_explicit(&ring_head, memory_order_acquire);
+        merged = 0;
+        printf("trace reset\n");
+        return 0;
+    }
+    frame_trace_dump();
+    return 0;
+}
+
+esp_err_t frame_trace_init(void) {
+    atomic_init(&in_flight_ready, false);
+    atomic_init(&ring_head, 0);
+
+    esp_err_t ret = bsp_lcd_set_vsync_cb(frame_trace_on_vsync, NULL);
+    if (ret != ESP_OK) {
+        ESP_LOGE(TAG, "Failed to register vsync callback");
+        return ret;
+    }
+
+    const esp_console_cmd_t cmd = {
+        .command = "trace",
+        .help = "Print frame latency histograms, 'trace reset' to start over",
+        .hint = "[reset]",
+        .func = trace_cmd,
+    };
+    ret = esp_console_cmd_register(&cmd);
+    if (ret != ESP_OK) {
+        ESP_LOGW(TAG, "Failed to register console command");
+    }
+    return ret;
+}
@@ -0,0 +1,66 @@
+/**
+ * @file frame_trace.h
+ * @date  16 October 2026
+
+ * @author Spencer Yan
+ *
+ * @note Per-frame latency trace from UART receive to LCD scan-out, dumped as histograms on the console
+ *
+ * @copyright © 2026, Seeed Studio
+ */
+
+#ifndef FRAME_TRACE_H
+#define FRAME_TRACE_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "esp_err.h"
+#include "main.h"
+#include "view_frame.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define FRAME_TRACE_RING_SIZE (128) // 必须是 2 的幂
+
+/**
+ * 一帧从接收到上屏的全部时间点. 流水线阶段的时间点由 view_frame 带过来,
+ * FLUSH 和 VSYNC 在 frame_trace 中补上, vsync 中断里写入环形缓冲区.
+ */
+typedef struct {
+    uint16_t seq; // RP2040 分配的序号
+    bool has_seq;
+    bool has_perf;
+    perf_t perf;                   // RP2040 上报的模型耗时, 毫秒
+    int64_t ts[VIEW_FRAME_TS_MAX]; // esp_timer_get_time(), 微秒, 0 表示没有经过
+} frame_trace_t;
+
+/**
+ * @brief 注册 vsync 回调和控制台命令 "trace", 须在 app_main 创建控制台之后调用
+ * @note  "trace" 打印各阶段的耗时直方图, "trace reset" 丢弃已有记录
+ */
+esp_err_t frame_trace_init(void);
+
+/**
+ * @brief 界面画完一帧, 等待下一次 disp_flush
+ * @note  须持有 lv_port_sem, 调用前须已记录 VIEW_FRAME_TS_RENDERED
+ */
+void frame_trace_rendered(const view_frame_t* frame);
+
+/**
+ * @brief LVGL 送出一次完整刷新时调用, 在 lvgl_task 中
+ */
+void frame_trace_flush(void);
+
+/**
+ * @brief 打印环形缓冲区中的记录的直方图
+ */
+void frame_trace_dump(void);
+
+#ifdef __cplusplus
+} /*extern "C"*/
+#endif
+
+#endif /*FRAME_TRACE_H*/
@@ -15,7 +15,6 @@
 //     esp_restart();
 // }
 #include "esp32_rp2040.h"
-extern bool is_name_geted;
 static void __btn_click_callback(void* arg)
 {
     // bool st=0;
@@ -25,7 +24,6 @@ static void __btn_click_callback(void* arg)
     //     esp_restart();
     //     return;
     // }
-    is_name_geted = false;
     // vTaskDelay(50/ portTICK_PERIOD_MS);
     // __cmd_send(PKT_TYPE_CMD_MODEL_TITLE, NULL, 0);
     ESP_LOGI("btn", "clicked");
@@ -0,0 +1,162 @@
+/**
+ * @file ui_bench.c
+ * @date  16 October 2026
+
+ * @author Spencer Yan
+ *
+ * @note Runs lv_demo_benchmark from the console to compare the LVGL render buffer modes
+ *       (sdkconfig.bench.direct / sdkconfig.bench.stripe build one mode each)
+ *
+ * @copyright © 2026, Seeed Studio
+ */
+
+#include "ui_bench.h"
+
+#include <stdbool.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "esp_console.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "lv_port.h"
+#include "lvgl.h"
+#include "sdkconfig.h"
+
+#if LV_USE_DEMO_BENCHMARK
+#include "demos/benchmark/lv_demo_benchmark.h"
+#endif
+
+static const char* TAG = "ui_bench";
+
+static const char* bench_mode(void) {
+#if CONFIG_LCD_LVGL_SRAM_STRIPE
+    return "partial refresh, SRAM stripe buffers";
+#elif CONFIG_LCD_LVGL_DIRECT_MODE
+    return "direct mode, PSRAM frame buffers";
+#elif CONFIG_LCD_LVGL_FULL_REFRESH
+    return "full refresh, PSRAM frame buffers";
+#else
+    return "partial refresh, PSRAM buffer";
+#endif
+}
+
+#if LV_USE_DEMO_BENCHMARK
+// 以下由 lv_port_sem 保护
+static lv_obj_t* app_scr; // 跑分前的界面
+static lv_obj_t* bench_scr;
+static bool running;
+static bool finished; // 跑分的统计不会清零, 每次开机只能跑一次
+static void (*demo_monitor_cb)(lv_disp_drv_t* drv, uint32_t time, uint32_t px);
+static int64_t start_time;
+static uint32_t refr_count;
+static uint64_t refr_time_ms;
+static uint64_t refr_px;
+
+static void bench_monitor_cb(lv_disp_drv_t* drv, uint32_t time, uint32_t px) {
+    refr_count++;
+    refr_time_ms += time;
+    refr_px += px;
+    demo_monitor_cb(drv, time, px);
+}
+
+#if LV_USE_LOG
+// LVGL 8.3 读不到已注册的打印回调; 应用本身不注册, 跑分之前就是 NULL, 注册时改这里
+static const lv_log_print_g_cb_t app_log_cb = NULL;
+
+static void bench_log(const char* buf) {
+    printf("%s", buf);
+}
+#endif
+
+/* 所有场景跑完, 在 lvgl_task 中 */
+static void bench_finished(void) {
+    int64_t elapsed = esp_timer_get_time() - start_time;
+
+    lv_disp_get_default()->driver->monitor_cb = NULL;
+#if LV_USE_LOG
+    // 跑分的结果已经打印完
+    lv_log_register_print_cb(app_log_cb);
+#endif
+    running = false;
+    finished = true;
+    printf("bench: %s, %lu refreshes in %.1f s, %.2f ms per refresh, %.1f px per ms\n", bench_mode(),
+           (unsigned long)refr_count, elapsed / 1e6, refr_count > 0 ? (double)refr_time_ms / refr_count : 0.0,
+           refr_time_ms > 0 ? (double)refr_px / refr_time_ms : 0.0);
+    printf("bench: 'bench exit' returns to the camera view\n");
+}
+
+static void bench_start(void) {
+    app_scr = lv_scr_act();
+    bench_scr = lv_obj_create(NULL);
+    lv_scr_load(bench_scr);
+
+#if LV_USE_LOG
+    lv_log_register_print_cb(bench_log);
+#endif
+    lv_demo_benchmark_set_finished_cb(bench_finished);
+    lv_demo_benchmark_set_max_speed(true);
+    lv_demo_benchmark();
+
+    // 跑分自己的 monitor_cb 算每个场景的帧率, 外面再套一层算总的
+    lv_disp_t* disp = lv_disp_get_default();
+    demo_monitor_cb = disp->driver->monitor_cb;
+    disp->driver->monitor_cb = bench_monitor_cb;
+    refr_count = 0;
+    refr_time_ms = 0;
+    refr_px = 0;
+    start_time = esp_timer_get_time();
+    running = true;
+}
+
+static void bench_exit(void) {
+    lv_scr_load(app_scr);
+    lv_obj_del(bench_scr);
+    bench_scr = NULL;
+}
+
+static int bench_cmd(int argc, char** argv) {
+    bool exit = argc > 1 && strcmp(argv[1], "exit") == 0;
+    const char* msg = NULL;
+
+    lv_port_sem_take();
+    if (running) {
+        msg = "benchmark is running";
+    } else if (exit) {
+        if (bench_scr != NULL) {
+            bench_exit();
+        }
+    } else if (finished) {
+        msg = "benchmark already ran, reboot to run it again";
+    } else {
+        bench_start();
+        msg = bench_mode();
+    }
+    lv_port_sem_give();
+    lv_port_render_request();
+
+    if (msg != NULL) {
+        printf("bench: %s\n", msg);
+    }
+    return 0;
+}
+#else
+static int bench_cmd(int argc, char** argv) {
+    printf("bench: %s, enable CONFIG_LV_USE_DEMO_BENCHMARK to run lv_demo_benchmark\n", bench_mode());
+    return 0;
+}
+#endif
+
+esp_err_t ui_bench_init(void) {
+    const esp_console_cmd_t cmd = {
+        .command = "bench",
+        .help = "Run lv_demo_benchmark in the current render mode, 'bench exit' to go back",
+        .hint = "[exit]",
+        .func = bench_cmd,
+    };
+    esp_err_t ret = esp_console_cmd_register(&cmd);
+    if (ret != ESP_OK) {
+        ESP_LOGW(TAG, "Failed to register console command");
+    }
+    return ret;
+}
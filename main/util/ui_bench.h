@@ -0,0 +1,40 @@
+/**
+ * @file ui_bench.h
+ * @date  16 October 2026
+
+ * @author Spencer Yan
+ *
+ * @note Runs lv_demo_benchmark from the console to compare the LVGL render buffer modes
+ *
+ * @copyright © 2026, Seeed Studio
+ */
+
+#ifndef UI_BENCH_H
+#define UI_BENCH_H
+
+#include "esp_err.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * 渲染模式在编译时选择 (components/bsp 的 Kconfig):
+ *   CONFIG_LCD_LVGL_DIRECT_MODE   两块 PSRAM 帧缓冲区, 默认
+ *   CONFIG_LCD_LVGL_SRAM_STRIPE   内部 SRAM 中的两条缓冲区, RGB 屏经 bounce buffer 扫描输出
+ * 两种固件各跑一次 "bench", 比较 LVGL 的 CSV 结果 (需要 CONFIG_LV_USE_LOG) 和最后一行的汇总:
+ * 刷新次数, 每次刷新的平均耗时 (绘制 + flush) 和每毫秒画出的像素.
+ * 跑分时摄像头的画面仍在后台解码, 比较时保持相同的条件.
+ */
+
+/**
+ * @brief 注册控制台命令 "bench", 须在 app_main 创建控制台之后调用
+ * @note  没有打开 CONFIG_LV_USE_DEMO_BENCHMARK 时命令只打印提示
+ */
+esp_err_t ui_bench_init(void);
+
+#ifdef __cplusplus
+} /*extern "C"*/
+#endif
+
+#endif /*UI_BENCH_H*/
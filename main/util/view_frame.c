@@ -0,0 +1,105 @@
+/**
+ * @file view_frame.c
+ * @date  16 October 2026
+
+ * @author Spencer Yan
+ *
+ * @note One frame's image and detection results, posted to the view as a single VIEW_EVENT_FRAME
+ *
+ * @copyright © 2026, Seeed Studio
+ */
+
+#include "view_frame.h"
+#include "esp_heap_caps.h"
+#include "esp_log.h"
+#include <inttypes.h>
+#include <string.h>
+
+static const char* TAG = "view_frame";
+
+static view_frame_t* view_frames;
+
+esp_err_t view_frame_pool_init(void) {
+    view_frames = (view_frame_t*)heap_caps_calloc(VIEW_FRAME_POOL_SIZE, sizeof(view_frame_t), MALLOC_CAP_SPIRAM);
+    if (view_frames == NULL) {
+        ESP_LOGE(TAG, "Failed to allocate view frames");
+        return ESP_ERR_NO_MEM;
+    }
+    for (int i = 0; i < VIEW_FRAME_POOL_SIZE; i++) {
+        atomic_init(&view_frames[i].busy, false);
+    }
+    return ESP_OK;
+}
+
+view_frame_t* view_frame_alloc(void) {
+    for (int i = 0; i < VIEW_FRAME_POOL_SIZE; i++) {
+        bool expected = false;
+        if (atomic_compare_exchange_strong(&view_frames[i].busy, &expected, true)) {
+            view_frames[i].img = NULL;
+            view_frames[i].canvas_buf = NULL;
+            memset(view_frames[i].ts, 0, sizeof(view_frames[i].ts));
+            sscma_result_clear(&view_frames[i].result);
+            return &view_frames[i];
+        }
+    }
+    return NULL;
+}
+
+void view_frame_free(view_frame_t* frame) {
+    if (frame == NULL) {
+        return;
+    }
+    frame_buf_unref(frame->img);
+    frame->img = NULL;
+    atomic_store(&frame->busy, false);
+}
+
+void view_frame_log_timing(const view_frame_t* frame) {
+    static int64_t sum[VIEW_FRAME_TS_MAX];
+    static int64_t max_total;
+    static int64_t window_start;
+    static uint32_t count;
+
+    for (int i = 1; i <= VIEW_FRAME_TS_RENDERED; i++) {
+        sum[i] += frame->ts[i] - frame->ts[i - 1];
+    }
+    int64_t total = frame->ts[VIEW_FRAME_TS_RENDERED] - frame->ts[VIEW_FRAME_TS_RX];
+    sum[0] += total;
+    if (total > max_total) {
+        max_total = total;
+    }
+    if (count++ == 0) {
+        window_start = frame->ts[VIEW_FRAME_TS_RENDERED];
+        return;
+    }
+    if (count < VIEW_FRAME_TIMING_INTERVAL) {
+        return;
+    }
+
+    // 吞吐量由最慢的阶段决定, 排队时间长说明下游是瓶颈
+    int64_t elapsed = frame->ts[VIEW_FRAME_TS_RENDERED] - window_start;
+    ESP_LOGI(TAG,
+             "%lu frames, %.1f fps, avg us: base64 %" PRId64 ", parse %" PRId64 ", decode queue %" PRId64
+             ", decode %" PRId64 ", render queue %" PRId64 ", render %" PRId64 ", total %" PRId64 " (max %" PRId64 ")",
+             (unsigned long)count, elapsed > 0 ? (count - 1) * 1e6 / elapsed : 0.0,
+             sum[VIEW_FRAME_TS_B64] / count, sum[VIEW_FRAME_TS_PARSED] / count,
+             sum[VIEW_FRAME_TS_DECODE_START] / count, sum[VIEW_FRAME_TS_DECODED] / count,
+             sum[VIEW_FRAME_TS_RENDER_START] / count, sum[VIEW_FRAME_TS_RENDERED] / count, sum[0] / count, max_total);
+
+    memset(sum, 0, sizeof(sum));
+    max_total = 0;
+    count = 0;
+}
+
+void view_frame_arena_stats(size_t* high_water, size_t* size, uint32_t* overflows) {
+    *high_water = 0;
+    *size = SSCMA_KEYPOINT_ARENA_SIZE;
+    *overflows = 0;
+    for (int i = 0; i < VIEW_FRAME_POOL_SIZE; i++) {
+        const frame_arena_t* arena = &view_frames[i].result.arena;
+        if (arena->high_water > *high_water) {
+            *high_water = arena->high_water;
+        }
+        *overflows += arena->overflows;
+    }
+}
@@ -0,0 +1,115 @@
+/**
+ * @file view_frame.h
+ * @date  16 October 2026
+
+ * @author Spencer Yan
+ *
+ * @note One frame's image and detection results, posted to the view as a single VIEW_EVENT_FRAME
+ *
+ * @copyright © 2026, Seeed Studio
+ */
+
+#ifndef VIEW_FRAME_H
+#define VIEW_FRAME_H
+
+#include <stdatomic.h>
+#include <stdbool.h>
+
+#include "esp_err.h"
+#include "esp_timer.h"
+#include "frame_pool.h"
+#include "sscma_parser.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define VIEW_FRAME_POOL_SIZE (4) // 解析中的暂存帧 + 解码 + 显示, 再留一帧余量
+#define VIEW_FRAME_TIMING_INTERVAL (100) // 每显示多少帧打印一次各阶段耗时
+
+/**
+ * 流水线各阶段的时间点, 相邻两个时间点之差就是该阶段 (或排队) 的耗时
+ */
+typedef enum {
+    VIEW_FRAME_TS_RX = 0,       // 这一帧的第一行 (或二进制帧) 在 UART 上接收完成
+    VIEW_FRAME_TS_B64,          // JPEG 字节就绪: 边收边解时与 RX 相同, 行内图像在解析后解码
+    VIEW_FRAME_TS_PARSED,       // 检测结果解析完成, 进入解码队列
+    VIEW_FRAME_TS_DECODE_START, // 解码任务取出
+    VIEW_FRAME_TS_DECODED,      // JPEG 已解码到后台画布缓冲区, 进入界面事件队列
+    VIEW_FRAME_TS_RENDER_START, // 界面任务取出
+    VIEW_FRAME_TS_RENDERED,     // 画布已切换, 叠加层已画完
+    VIEW_FRAME_TS_FLUSH,        // disp_flush 送出包含这一帧的画面, 由 frame_trace 记录
+    VIEW_FRAME_TS_VSYNC,        // 之后的第一个 vsync, 开始扫描输出, 由 frame_trace 记录
+    VIEW_FRAME_TS_MAX,
+} view_frame_ts_t;
+
+/**
+ * @brief VIEW_EVENT_FRAME 的内容
+ * @note  事件里只传递指针, 事件处理函数画完后调用 view_frame_free() 归还
+ */
+typedef struct {
+    frame_buf_t* img;      // 与 result 对应的 JPEG, NULL 表示这一帧没有图像
+    sscma_result_t result; // boxes / classes / points / keypoints / perf
+
+    uint8_t* canvas_buf; // 解码任务填好的后台画布缓冲区, 由界面任务换上, NULL 表示没有新画面
+    uint16_t canvas_w;   // 图像在 canvas_buf 中覆盖的宽高
+    uint16_t canvas_h;
+    uint8_t canvas_scale; // 图像缩小为 1/2^canvas_scale 放进画布, 检测结果的坐标也要同样缩小
+
+    int64_t ts[VIEW_FRAME_TS_MAX]; // esp_timer_get_time(), 微秒, 0 表示没有经过
+    atomic_bool busy;
+} view_frame_t;
+
+/**
+ * @brief 记录 frame 到达某个阶段的时间
+ */
+static inline void view_frame_stamp(view_frame_t* frame, view_frame_ts_t ts) {
+    frame->ts[ts] = esp_timer_get_time();
+}
+
+/**
+ * @brief 记录 frame 的第一条消息的接收时间, 同一帧的后续消息不会覆盖
+ */
+static inline void view_frame_stamp_rx(view_frame_t* frame, int64_t t_rx) {
+    if (frame->ts[VIEW_FRAME_TS_RX] == 0) {
+        frame->ts[VIEW_FRAME_TS_RX] = t_rx;
+    }
+}
+
+/**
+ * @brief 从 PSRAM 分配 VIEW_FRAME_POOL_SIZE 个 view_frame_t
+ */
+esp_err_t view_frame_pool_init(void);
+
+/**
+ * @brief 取一个空闲的 view_frame_t, 其中的结果和时间点已清空
+ *
+ * @return NULL 表示界面还没画完之前的帧
+ */
+view_frame_t* view_frame_alloc(void);
+
+/**
+ * @brief 归还 view_frame_t, 同时释放其中的图像
+ */
+void view_frame_free(view_frame_t* frame);
+
+/**
+ * @brief 累计一帧各阶段的耗时, 每 VIEW_FRAME_TIMING_INTERVAL 帧打印一次平均值
+ * @note  只在界面任务中调用, 调用前须已记录 VIEW_FRAME_TS_RENDERED
+ */
+void view_frame_log_timing(const view_frame_t* frame);
+
+/**
+ * @brief 汇总所有 view_frame_t 的关键点 arena 用量
+ *
+ * @param high_water 单帧最大用量 (字节)
+ * @param size 单帧容量 (字节)
+ * @param overflows 空间不足的总帧数
+ */
+void view_frame_arena_stats(size_t* high_water, size_t* size, uint32_t* overflows);
+
+#ifdef __cplusplus
+} /*extern "C"*/
+#endif
+
+#endif /*VIEW_FRAME_H*/
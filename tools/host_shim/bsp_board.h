@@ -0,0 +1,7 @@
+/**
+ * @file bsp_board.h
+ * @note Host build shim, only what the app sources need
+ */
+#pragma once
+#include <stdbool.h>
+#include "esp_err.h"
@@ -0,0 +1,12 @@
+/**
+ * @file esp_event_base.h
+ * @note Host build shim, only what the app sources need
+ */
+#pragma once
+#include <stdint.h>
+
+typedef const char* esp_event_base_t;
+typedef void* esp_event_loop_handle_t;
+
+#define ESP_EVENT_DECLARE_BASE(id) extern esp_event_base_t const id
+#define ESP_EVENT_DEFINE_BASE(id) esp_event_base_t const id = #id
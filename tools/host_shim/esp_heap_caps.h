@@ -0,0 +1,21 @@
+/**
+ * @file esp_heap_caps.h
+ * @note Host build shim, only what the app sources need. Allocations are counted in host_heap.c
+ */
+#pragma once
+#include <stddef.h>
+#include <stdint.h>
+
+#define MALLOC_CAP_8BIT (1 << 2)
+#define MALLOC_CAP_DMA (1 << 3)
+#define MALLOC_CAP_SPIRAM (1 << 10)
+#define MALLOC_CAP_INTERNAL (1 << 11)
+#define MALLOC_CAP_DEFAULT (1 << 12)
+
+void* heap_caps_malloc(size_t size, uint32_t caps);
+void* heap_caps_calloc(size_t n, size_t size, uint32_t caps);
+void heap_caps_free(void* ptr);
+
+/* host only: bytes currently allocated and the peak since start */
+size_t host_heap_used(void);
+size_t host_heap_peak(void);
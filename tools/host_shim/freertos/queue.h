@@ -0,0 +1,8 @@
+/**
+ * @file queue.h
+ * @note Host build shim, only what the app sources need
+ */
+#pragma once
+#include "freertos/FreeRTOS.h"
+
+typedef void* QueueHandle_t;
@@ -0,0 +1,10 @@
+/**
+ * @file task.h
+ * @note Host build shim, only what the app sources need
+ */
+#pragma once
+#include "freertos/FreeRTOS.h"
+
+static inline void vTaskDelay(TickType_t ticks) {
+    (void)ticks;
+}
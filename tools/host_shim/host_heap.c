@@ -0,0 +1,54 @@
+/**
+ * @file host_heap.c
+ * @note Host build shim: heap_caps_* on top of malloc, with a running total and peak
+ */
+#include <stdlib.h>
+#include <string.h>
+#include "esp_heap_caps.h"
+
+typedef union {
+    size_t size;
+    max_align_t align;
+} heap_hdr_t;
+
+static size_t heap_used;
+static size_t heap_peak;
+
+void* heap_caps_malloc(size_t size, uint32_t caps) {
+    (void)caps;
+    heap_hdr_t* hdr = malloc(sizeof(heap_hdr_t) + size);
+    if (hdr == NULL) {
+        return NULL;
+    }
+    hdr->size = size;
+    heap_used += size;
+    if (heap_used > heap_peak) {
+        heap_peak = heap_used;
+    }
+    return hdr + 1;
+}
+
+void* heap_caps_calloc(size_t n, size_t size, uint32_t caps) {
+    void* p = heap_caps_malloc(n * size, caps);
+    if (p != NULL) {
+        memset(p, 0, n * size);
+    }
+    return p;
+}
+
+void heap_caps_free(void* ptr) {
+    if (ptr == NULL) {
+        return;
+    }
+    heap_hdr_t* hdr = (heap_hdr_t*)ptr - 1;
+    heap_used -= hdr->size;
+    free(hdr);
+}
+
+size_t host_heap_used(void) {
+    return heap_used;
+}
+
+size_t host_heap_peak(void) {
+    return heap_peak;
+}
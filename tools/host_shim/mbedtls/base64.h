@@ -0,0 +1,53 @@
+/**
+ * @file base64.h
+ * @note Host build shim, only what the app sources need
+ */
+#pragma once
+#include <stddef.h>
+
+#define MBEDTLS_ERR_BASE64_BUFFER_TOO_SMALL -0x002A
+#define MBEDTLS_ERR_BASE64_INVALID_CHARACTER -0x002C
+
+static inline int mbedtls_base64_sextet(unsigned char c) {
+    if (c >= 'A' && c <= 'Z') return c - 'A';
+    if (c >= 'a' && c <= 'z') return c - 'a' + 26;
+    if (c >= '0' && c <= '9') return c - '0' + 52;
+    if (c == '+') return 62;
+    if (c == '/') return 63;
+    return -1;
+}
+
+static inline int mbedtls_base64_decode(unsigned char* dst, size_t dlen, size_t* olen, const unsigned char* src,
+                                        size_t slen) {
+    size_t n = 0, pad = 0;
+    for (size_t i = 0; i < slen; i++) {
+        if (src[i] == '=') {
+            pad++;
+        } else if (mbedtls_base64_sextet(src[i]) < 0 || pad > 0) {
+            return MBEDTLS_ERR_BASE64_INVALID_CHARACTER;
+        } else {
+            n++;
+        }
+    }
+    if ((n + pad) % 4 != 0 || pad > 2) {
+        return MBEDTLS_ERR_BASE64_INVALID_CHARACTER;
+    }
+
+    *olen = (n * 6) / 8;
+    if (dst == NULL || dlen < *olen) {
+        return MBEDTLS_ERR_BASE64_BUFFER_TOO_SMALL;
+    }
+
+    unsigned int acc = 0;
+    int bits = 0;
+    size_t out = 0;
+    for (size_t i = 0; i < n; i++) {
+        acc = (acc << 6) | mbedtls_base64_sextet(src[i]);
+        bits += 6;
+        if (bits >= 8) {
+            bits -= 8;
+            dst[out++] = (acc >> bits) & 0xFF;
+        }
+    }
+    return 0;
+}
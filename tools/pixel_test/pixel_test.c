@@ -0,0 +1,118 @@
+/**
+ * @file pixel_test.c
+ * @date  16 October 2026
+
+ * @author Spencer Yan
+ *
+ * @note Host test: main/draw/pixel_ops.c against lv_color_make() and lv_canvas_fill_bg()
+ *
+ * @copyright © 2026, Seeed Studio
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "pixel_ops.h"
+
+#define DISP_HOR_RES (32)
+#define DISP_VER_RES (32)
+
+/* 画布尺寸: 单个像素、奇数宽高、与屏上的画布相同 */
+static const lv_coord_t sizes[][2] = {{1, 1}, {3, 5}, {17, 2}, {240, 240}};
+
+static uint32_t rng_state = 0x12345678;
+static unsigned long cases;
+static unsigned long mismatches;
+
+static uint32_t rng(void) {
+    rng_state ^= rng_state << 13;
+    rng_state ^= rng_state >> 17;
+    rng_state ^= rng_state << 5;
+    return rng_state;
+}
+
+/* tjpgd 输出的每一种 RGB888 值 */
+static void test_rgb888(void) {
+    static uint8_t rgb[256 * 3];
+    static lv_color_t got[256];
+
+    for (int r = 0; r < 256; r++) {
+        for (int g = 0; g < 256; g++) {
+            for (int b = 0; b < 256; b++) {
+                rgb[b * 3] = r;
+                rgb[b * 3 + 1] = g;
+                rgb[b * 3 + 2] = b;
+            }
+            pixel_rgb888_to_color(got, rgb, 256);
+            for (int b = 0; b < 256; b++) {
+                lv_color_t want = lv_color_make(r, g, b);
+                cases++;
+                if (got[b].full != want.full && mismatches++ < 10) {
+                    printf("rgb888: %02x%02x%02x is 0x%04x, expected 0x%04x\n", r, g, b, got[b].full, want.full);
+                }
+            }
+        }
+    }
+}
+
+/* 两块画布先填随机内容, 分别用 pixel_canvas_fill() 和 lv_canvas_fill_bg() 填满后比较 */
+static void test_canvas_fill(void) {
+    for (size_t s = 0; s < sizeof(sizes) / sizeof(sizes[0]); s++) {
+        lv_coord_t w = sizes[s][0], h = sizes[s][1];
+        size_t n = (size_t)w * h;
+        lv_color_t* got = malloc(n * sizeof(lv_color_t));
+        lv_color_t* want = malloc(n * sizeof(lv_color_t));
+        lv_obj_t* got_canvas = lv_canvas_create(lv_scr_act());
+        lv_obj_t* want_canvas = lv_canvas_create(lv_scr_act());
+        lv_canvas_set_buffer(got_canvas, got, w, h, LV_IMG_CF_TRUE_COLOR);
+        lv_canvas_set_buffer(want_canvas, want, w, h, LV_IMG_CF_TRUE_COLOR);
+
+        for (int i = 0; i < 16; i++) {
+            lv_color_t color = {.full = (uint16_t)rng()};
+            for (size_t p = 0; p < n; p++) {
+                got[p].full = want[p].full = (uint16_t)rng();
+            }
+            pixel_canvas_fill(got_canvas, color);
+            lv_canvas_fill_bg(want_canvas, color, LV_OPA_COVER);
+
+            cases++;
+            if (memcmp(got, want, n * sizeof(lv_color_t)) != 0 && mismatches++ < 10) {
+                printf("canvas fill: %dx%d, color 0x%04x differs from lv_canvas_fill_bg()\n", w, h, color.full);
+            }
+        }
+
+        lv_obj_del(got_canvas);
+        lv_obj_del(want_canvas);
+        free(got);
+        free(want);
+    }
+}
+
+static void flush_cb(lv_disp_drv_t* drv, const lv_area_t* area, lv_color_t* color_p) {
+    (void)area;
+    (void)color_p;
+    lv_disp_flush_ready(drv);
+}
+
+int main(void) {
+    static lv_color_t draw_buf_px[DISP_HOR_RES * DISP_VER_RES];
+    static lv_disp_draw_buf_t draw_buf;
+    static lv_disp_drv_t disp_drv;
+
+    // 画布要挂在屏幕上, 注册一个不输出的显示器
+    lv_init();
+    lv_disp_draw_buf_init(&draw_buf, draw_buf_px, NULL, DISP_HOR_RES * DISP_VER_RES);
+    lv_disp_drv_init(&disp_drv);
+    disp_drv.hor_res = DISP_HOR_RES;
+    disp_drv.ver_res = DISP_VER_RES;
+    disp_drv.draw_buf = &draw_buf;
+    disp_drv.flush_cb = flush_cb;
+    lv_disp_drv_register(&disp_drv);
+
+    test_rgb888();
+    test_canvas_fill();
+
+    printf("pixel_test: %lu cases, %lu mismatches\n", cases, mismatches);
+    return mismatches == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,409 @@
+/**
+ * @file replay.c
+ * @date  16 October 2026
+
+ * @author Spencer Yan
+ *
+ * @note Host replay: feeds a recorded RP2040 UART capture through the firmware's rx, parse, decode and render
+ *       stages, rendering headless into a memory framebuffer
+ *
+ * @copyright © 2026, Seeed Studio
+ */
+
+#include <getopt.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "app_boxes.h"
+#include "app_image.h"
+#include "app_keypoints.h"
+#include "esp_heap_caps.h"
+#include "esp_rom_crc.h"
+#include "esp_timer.h"
+#include "frame_pipeline.h"
+#include "frame_pool.h"
+#include "rp2040_rx.h"
+#include "view_frame.h"
+
+#define SCREEN_WIDTH (480)
+#define SCREEN_HEIGHT (480)
+#define UART_RX_BUFFER_SIZE (40 * 1024) // 与 esp32_rp2040.c 中 uart_driver_install() 的缓冲区相同
+#define UART_READ_CHUNK (256)
+#define MSG_QUEUE_SIZE (20) // JSON_QUEUE_SIZE
+#define CANVAS_LEFT_BUF_NUM (2)
+
+typedef struct {
+    int64_t sum;
+    int64_t max;
+    uint32_t count;
+} stage_stat_t;
+
+typedef struct {
+    const char* name;
+    view_frame_ts_t from;
+    view_frame_ts_t to;
+} stage_t;
+
+static const stage_t stages[] = {
+    {"base64", VIEW_FRAME_TS_RX, VIEW_FRAME_TS_B64},
+    {"parse", VIEW_FRAME_TS_B64, VIEW_FRAME_TS_PARSED},
+    {"decode", VIEW_FRAME_TS_DECODE_START, VIEW_FRAME_TS_DECODED},
+    {"render", VIEW_FRAME_TS_RENDER_START, VIEW_FRAME_TS_RENDERED},
+    {"total", VIEW_FRAME_TS_RX, VIEW_FRAME_TS_RENDERED},
+};
+#define STAGE_NUM (sizeof(stages) / sizeof(stages[0]))
+
+static lv_color_t framebuffer[SCREEN_WIDTH * SCREEN_HEIGHT];
+static lv_disp_draw_buf_t draw_buf;
+static lv_disp_drv_t disp_drv;
+
+static lv_obj_t* canvas_left;
+static lv_obj_t* canvas_right;
+static uint8_t* canvas_free[CANVAS_LEFT_BUF_NUM];
+static int canvas_free_count;
+
+static rp2040_msg_t msg_queue[MSG_QUEUE_SIZE];
+static int msg_head, msg_count;
+
+static view_frame_t* decode_queue[VIEW_FRAME_POOL_SIZE];
+static int decode_count;
+
+static stage_stat_t stage_stats[STAGE_NUM];
+static uint32_t frames_rendered;
+static uint32_t seq_gaps;
+static size_t uart_overflow_bytes;
+static int last_seq = -1;
+
+static FILE* crc_record;
+static FILE* crc_check;
+static uint32_t crc_mismatches;
+
+/* 回放是单线程的, app_boxes.c 中的旧接口仍会调用 LVGL 锁 */
+void lv_port_sem_take(void) {
+}
+
+void lv_port_sem_give(void) {
+}
+
+static void disp_flush(lv_disp_drv_t* drv, const lv_area_t* area, lv_color_t* color_p) {
+    (void)area;
+    (void)color_p;
+    lv_disp_flush_ready(drv);
+}
+
+static void display_init(void) {
+    lv_init();
+    lv_disp_draw_buf_init(&draw_buf, framebuffer, NULL, SCREEN_WIDTH * SCREEN_HEIGHT);
+    lv_disp_drv_init(&disp_drv);
+    disp_drv.hor_res = SCREEN_WIDTH;
+    disp_drv.ver_res = SCREEN_HEIGHT;
+    disp_drv.flush_cb = disp_flush;
+    disp_drv.draw_buf = &draw_buf;
+    disp_drv.direct_mode = 1; // 和固件一样, LVGL 直接画在帧缓冲区里
+    lv_disp_drv_register(&disp_drv);
+}
+
+/* 与 app_main() 中的画布一致 */
+static int canvas_init(void) {
+    uint8_t* cbuf_left = heap_caps_malloc(LV_IMG_BUF_SIZE_TRUE_COLOR(CANVAS_WIDTH, CANVAS_HEIGHT), MALLOC_CAP_SPIRAM);
+    uint8_t* cbuf_right = heap_caps_malloc(LV_IMG_BUF_SIZE_TRUE_COLOR(CANVAS_WIDTH, CANVAS_HEIGHT), MALLOC_CAP_SPIRAM);
+    if (cbuf_left == NULL || cbuf_right == NULL) {
+        return -1;
+    }
+    for (int i = 1; i < CANVAS_LEFT_BUF_NUM; i++) {
+        canvas_free[canvas_free_count] =
+            heap_caps_calloc(1, LV_IMG_BUF_SIZE_TRUE_COLOR(CANVAS_WIDTH, CANVAS_HEIGHT), MALLOC_CAP_SPIRAM);
+        if (canvas_free[canvas_free_count] == NULL) {
+            return -1;
+        }
+        canvas_free_count++;
+    }
+
+    canvas_left = lv_canvas_create(lv_scr_act());
+    canvas_right = lv_canvas_create(lv_scr_act());
+    lv_canvas_set_buffer(canvas_left, cbuf_left, CANVAS_WIDTH, CANVAS_HEIGHT, LV_IMG_CF_TRUE_COLOR);
+    lv_canvas_set_buffer(canvas_right, cbuf_right, CANVAS_WIDTH, CANVAS_HEIGHT, LV_IMG_CF_TRUE_COLOR);
+    lv_obj_align(canvas_left, LV_ALIGN_LEFT_MID, 0, 0);
+    lv_obj_align(canvas_right, LV_ALIGN_RIGHT_MID, 0, 0);
+    lv_canvas_fill_bg(canvas_left, lv_palette_main(LV_PALETTE_NONE), LV_OPA_COVER);
+    lv_canvas_fill_bg(canvas_right, lv_palette_main(LV_PALETTE_GREY), LV_OPA_COVER);
+
+    init_image();
+    init_keypoints_app();
+    init_boxes_app();
+    return 0;
+}
+
+static bool rx_to_queue(const rp2040_msg_t* msg) {
+    if (msg_count == MSG_QUEUE_SIZE) {
+        return false;
+    }
+    msg_queue[(msg_head + msg_count) % MSG_QUEUE_SIZE] = *msg;
+    msg_count++;
+    return true;
+}
+
+static bool rx_evict_from_queue(uint32_t types, rp2040_msg_t* out) {
+    for (int i = 0; i < msg_count; i++) {
+        rp2040_msg_t* msg = &msg_queue[(msg_head + i) % MSG_QUEUE_SIZE];
+        if (types & RP2040_RX_MASK(msg->type)) {
+            *out = *msg;
+            for (int j = i + 1; j < msg_count; j++) {
+                msg_queue[(msg_head + j - 1) % MSG_QUEUE_SIZE] = msg_queue[(msg_head + j) % MSG_QUEUE_SIZE];
+            }
+            msg_count--;
+            return true;
+        }
+    }
+    return false;
+}
+
+static void queue_for_decode(view_frame_t* frame) {
+    decode_queue[decode_count++] = frame;
+}
+
+static void check_checksum(uint32_t crc, int seq) {
+    if (crc_record != NULL) {
+        fprintf(crc_record, "%u %d %08x\n", frames_rendered, seq, crc);
+    }
+    if (crc_check != NULL) {
+        unsigned int index, expected;
+        int expected_seq;
+        if (fscanf(crc_check, "%u %d %x", &index, &expected_seq, &expected) != 3) {
+            fprintf(stderr, "frame %u (seq %d): no reference checksum\n", frames_rendered, seq);
+            crc_mismatches++;
+        } else if (expected != crc || expected_seq != seq) {
+            fprintf(stderr, "frame %u (seq %d): checksum %08x, expected %08x (seq %d)\n", frames_rendered, seq, crc,
+                    expected, expected_seq);
+            crc_mismatches++;
+        }
+    }
+}
+
+/* 解码和显示, 对应 frame_decode_task 和 view_event_task */
+static void render_frame(view_frame_t* frame) {
+    view_frame_stamp(frame, VIEW_FRAME_TS_DECODE_START);
+    if (frame->img != NULL && canvas_free_count > 0) {
+        uint8_t* buf = canvas_free[--canvas_free_count];
+        if (!frame_pipeline_decode(frame, buf)) {
+            canvas_free[canvas_free_count++] = buf;
+        }
+    }
+    view_frame_stamp(frame, VIEW_FRAME_TS_DECODED);
+
+    view_frame_stamp(frame, VIEW_FRAME_TS_RENDER_START);
+    uint8_t* old = frame_pipeline_render(frame, canvas_left, canvas_right);
+    if (old != NULL) {
+        canvas_free[canvas_free_count++] = old;
+    }
+    lv_refr_now(NULL);
+    view_frame_stamp(frame, VIEW_FRAME_TS_RENDERED);
+
+    for (size_t i = 0; i < STAGE_NUM; i++) {
+        int64_t dt = frame->ts[stages[i].to] - frame->ts[stages[i].from];
+        stage_stats[i].sum += dt;
+        stage_stats[i].count++;
+        if (dt > stage_stats[i].max) {
+            stage_stats[i].max = dt;
+        }
+    }
+
+    int seq = (frame->result.fields & SSCMA_FIELD_SEQ) ? frame->result.seq : -1;
+    if (seq >= 0 && last_seq >= 0) {
+        uint16_t gap = (uint16_t)(seq - last_seq);
+        if (gap > 1 && gap < 0x8000) {
+            seq_gaps += gap - 1;
+        }
+    }
+    if (seq >= 0) {
+        last_seq = seq;
+    }
+
+    check_checksum(esp_rom_crc32_le(0, (const uint8_t*)framebuffer, sizeof(framebuffer)), seq);
+    frames_rendered++;
+    view_frame_free(frame);
+}
+
+/* 把 UART 读到的一段数据送进流水线, 处理完所有产生的帧 */
+static void feed(const uint8_t* data, int len) {
+    rp2040_rx_feed(data, len);
+
+    while (msg_count > 0) {
+        rp2040_msg_t msg = msg_queue[msg_head];
+        msg_head = (msg_head + 1) % MSG_QUEUE_SIZE;
+        msg_count--;
+
+        frame_pipeline_parse(&msg);
+        for (int i = 0; i < decode_count; i++) {
+            render_frame(decode_queue[i]);
+        }
+        decode_count = 0;
+    }
+}
+
+static uint8_t* load_file(const char* path, size_t* len) {
+    FILE* f = fopen(path, "rb");
+    if (f == NULL) {
+        perror(path);
+        return NULL;
+    }
+    fseek(f, 0, SEEK_END);
+    *len = ftell(f);
+    fseek(f, 0, SEEK_SET);
+    uint8_t* data = malloc(*len);
+    if (data != NULL && fread(data, 1, *len, f) != *len) {
+        free(data);
+        data = NULL;
+    }
+    fclose(f);
+    return data;
+}
+
+static void sleep_us(int64_t us) {
+    struct timespec ts = {.tv_sec = us / 1000000, .tv_nsec = (us % 1000000) * 1000};
+    nanosleep(&ts, NULL);
+}
+
+/**
+ * baud 为 0 时尽快送入; 否则按 8N1 的字节速率到达, 来不及处理的字节超过
+ * UART 接收缓冲区时被丢弃, 和固件一样
+ */
+static void replay(const uint8_t* data, size_t len, int baud) {
+    size_t consumed = 0;
+    int64_t start = esp_timer_get_time();
+
+    while (consumed < len) {
+        size_t arrived = len;
+        if (baud > 0) {
+            arrived = (size_t)((esp_timer_get_time() - start) * (baud / 10) / 1000000);
+            arrived = arrived < len ? arrived : len;
+            if (arrived - consumed > UART_RX_BUFFER_SIZE) {
+                size_t lost = arrived - consumed - UART_RX_BUFFER_SIZE;
+                uart_overflow_bytes += lost;
+                consumed += lost;
+                rp2040_rx_reset();
+            }
+            if (arrived == consumed) {
+                sleep_us(1000);
+                continue;
+            }
+        }
+
+        size_t n = arrived - consumed;
+        n = n < UART_READ_CHUNK ? n : UART_READ_CHUNK;
+        feed(data + consumed, (int)n);
+        consumed += n;
+    }
+}
+
+static void usage(const char* prog) {
+    fprintf(stderr,
+            "usage: %s [-b baud] [-n loops] [-p drop|latest] [-r record.crc | -c check.crc] capture\n"
+            "  -b  pace the capture at this UART baud rate (8N1), default: as fast as possible\n"
+            "  -n  replay the capture this many times\n"
+            "  -p  policy when the message queue is full: drop oldest image, or keep only the latest (default)\n"
+            "  -r  write one framebuffer checksum per rendered frame\n"
+            "  -c  compare framebuffer checksums against a file written by -r\n",
+            prog);
+}
+
+int main(int argc, char** argv) {
+    int baud = 0;
+    int loops = 1;
+    rp2040_rx_policy_t policy = RP2040_RX_COALESCE_LATEST;
+    const char* record_path = NULL;
+    const char* check_path = NULL;
+
+    int opt;
+    while ((opt = getopt(argc, argv, "b:n:p:r:c:h")) != -1) {
+        switch (opt) {
+        case 'b':
+            baud = atoi(optarg);
+            break;
+        case 'n':
+            loops = atoi(optarg);
+            break;
+        case 'p':
+            policy = strcmp(optarg, "drop") == 0 ? RP2040_RX_DROP_OLDEST_IMAGE : RP2040_RX_COALESCE_LATEST;
+            break;
+        case 'r':
+            record_path = optarg;
+            break;
+        case 'c':
+            check_path = optarg;
+            break;
+        default:
+            usage(argv[0]);
+            return 1;
+        }
+    }
+    if (optind != argc - 1 || (record_path && check_path)) {
+        usage(argv[0]);
+        return 1;
+    }
+
+    size_t len;
+    uint8_t* capture = load_file(argv[optind], &len);
+    if (capture == NULL) {
+        return 1;
+    }
+    if (record_path && (crc_record = fopen(record_path, "w")) == NULL) {
+        perror(record_path);
+        return 1;
+    }
+    if (check_path && (crc_check = fopen(check_path, "r")) == NULL) {
+        perror(check_path);
+        return 1;
+    }
+
+    display_init();
+    if (frame_pool_init(DECODED_IMAGE_MAX_SIZE) != ESP_OK || view_frame_pool_init() != ESP_OK ||
+        rp2040_rx_init(rx_to_queue, rx_evict_from_queue, policy) != ESP_OK || canvas_init() != 0) {
+        fprintf(stderr, "init failed\n");
+        return 1;
+    }
+    frame_pipeline_init(queue_for_decode);
+    lv_refr_now(NULL);
+
+    int64_t start = esp_timer_get_time();
+    for (int i = 0; i < loops; i++) {
+        replay(capture, len, baud);
+    }
+    int64_t elapsed = esp_timer_get_time() - start;
+
+    lv_mem_monitor_t mon;
+    lv_mem_monitor(&mon);
+
+    printf("%s: %zu bytes x %d, %u frames in %.2f s, %.1f frames/s\n", argv[optind], len, loops, frames_rendered,
+           elapsed / 1e6, elapsed > 0 ? frames_rendered * 1e6 / elapsed : 0.0);
+    printf("  stage      avg us   max us\n");
+    for (size_t i = 0; i < STAGE_NUM; i++) {
+        const stage_stat_t* s = &stage_stats[i];
+        printf("  %-8s %8lld %8lld\n", stages[i].name, s->count ? (long long)(s->sum / s->count) : 0LL,
+               (long long)s->max);
+    }
+    rp2040_rx_stats_t rx_stats;
+    rp2040_rx_get_stats(&rx_stats);
+    printf("  dropped: %u frames by seq, %zu bytes on UART overflow\n", seq_gaps, uart_overflow_bytes);
+    printf("  rx: %u received, %u dropped, %u overwritten, %u errors (%s)\n", rx_stats.received, rx_stats.dropped,
+           rx_stats.overwritten, rx_stats.errors, policy == RP2040_RX_COALESCE_LATEST ? "latest" : "drop");
+    printf("  peak heap: %zu bytes heap_caps, %u bytes lv_mem\n", host_heap_peak(), (unsigned)mon.max_used);
+
+    if (crc_check != NULL) {
+        unsigned int index, expected;
+        int expected_seq;
+        if (fscanf(crc_check, "%u %d %x", &index, &expected_seq, &expected) == 3) {
+            fprintf(stderr, "fewer frames rendered than in %s\n", check_path);
+            crc_mismatches++;
+        }
+        printf("  checksums: %u mismatches\n", crc_mismatches);
+        fclose(crc_check);
+    }
+    if (crc_record != NULL) {
+        fclose(crc_record);
+    }
+    free(capture);
+    return crc_mismatches ? 2 : 0;
+}
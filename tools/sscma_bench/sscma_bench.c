@@ -0,0 +1,235 @@
+/**
+ * @file sscma_bench.c
+ * @date  16 October 2026
+
+ * @author Spencer Yan
+ *
+ * @note Host benchmark: sscma_parse() against cJSON_Parse() + the old DOM walk, on recorded RP2040 lines
+ *
+ * @copyright © 2026, Seeed Studio
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "app_keypoints.h"
+#include "cJSON.h"
+#include "sscma_parser.h"
+
+#define MAX_LINES (4096)
+#define DEFAULT_ROUNDS (2000)
+
+static char* lines[MAX_LINES];
+static size_t line_lens[MAX_LINES];
+static int line_count;
+
+static size_t cjson_allocs;
+
+static void* count_malloc(size_t size) {
+    cjson_allocs++;
+    return malloc(size);
+}
+
+static double now_us(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1e6 + ts.tv_nsec / 1e3;
+}
+
+static int load_traffic(const char* path) {
+    FILE* f = fopen(path, "r");
+    if (f == NULL) {
+        perror(path);
+        return -1;
+    }
+
+    char* line = NULL;
+    size_t cap = 0;
+    ssize_t n;
+    while ((n = getline(&line, &cap, f)) > 0 && line_count < MAX_LINES) {
+        while (n > 0 && (line[n - 1] == '\n' || line[n - 1] == '\r')) {
+            line[--n] = '\0';
+        }
+        if (n == 0 || line[0] != '{') continue;
+        lines[line_count] = strdup(line);
+        line_lens[line_count] = n;
+        line_count++;
+    }
+    free(line);
+    fclose(f);
+    return line_count;
+}
+
+/* 改动前 app_keypoints.c 中的 ParseJsonKeypoints(): 每个人和每组关键点各 malloc 一次 */
+static void free_all_keypoints(keypoints_t* keypoints_array, size_t count) {
+    if (!keypoints_array) return;
+    for (size_t i = 0; i < count; ++i) {
+        free(keypoints_array[i].points);
+    }
+    free(keypoints_array);
+}
+
+static bool ParseJsonKeypoints(cJSON* keypoints_json, keypoints_t** keypoints_array, int* keypoints_count) {
+    int count = cJSON_GetArraySize(keypoints_json);
+    if (count <= 0) return false;
+
+    keypoints_t* kp_array = (keypoints_t*)calloc(count, sizeof(keypoints_t));
+    if (kp_array == NULL) return false;
+
+    for (int index = 0; index < count; index++) {
+        cJSON* keypointJson = cJSON_GetArrayItem(keypoints_json, index);
+        keypoints_t* current_keypoint = &kp_array[index];
+
+        cJSON* boxJson = cJSON_GetObjectItem(keypointJson, "box");
+        if (cJSON_IsArray(boxJson) && cJSON_GetArraySize(boxJson) == 6) {
+            for (int i = 0; i < 6; i++) {
+                cJSON* item = cJSON_GetArrayItem(boxJson, i);
+                if (item) current_keypoint->box.boxArray[i] = item->valueint;
+            }
+        }
+
+        cJSON* pointsJson = cJSON_GetObjectItem(keypointJson, "points");
+        if (!cJSON_IsArray(pointsJson)) continue;
+        size_t points_count = cJSON_GetArraySize(pointsJson);
+        if (points_count == 0) continue;
+        current_keypoint->points = (keypoint_t*)malloc(sizeof(keypoint_t) * points_count);
+        if (current_keypoint->points == NULL) {
+            free_all_keypoints(kp_array, count);
+            return false;
+        }
+        current_keypoint->points_count = points_count;
+
+        for (size_t p_idx = 0; p_idx < points_count; p_idx++) {
+            cJSON* point_json = cJSON_GetArrayItem(pointsJson, p_idx);
+            if (!cJSON_IsArray(point_json)) continue;
+
+            size_t point_dims = cJSON_GetArraySize(point_json);
+            size_t loop_count = (point_dims > 3) ? 3 : point_dims;
+            for (size_t i = 0; i < loop_count; i++) {
+                cJSON* item = cJSON_GetArrayItem(point_json, i);
+                if (item) current_keypoint->points[p_idx].point[i] = (uint16_t)item->valueint;
+            }
+        }
+    }
+
+    *keypoints_array = kp_array;
+    *keypoints_count = count;
+    return true;
+}
+
+/* 与改动前 process_json_data() 相同的 DOM 遍历方式 */
+typedef struct {
+    int boxes_count;
+    boxes_t boxes[SSCMA_MAX_BOXES];
+    keypoints_t* keypoints;
+    int keypoints_count;
+} dom_result_t;
+
+static bool parse_with_cjson(const char* str, dom_result_t* out) {
+    cJSON* json = cJSON_Parse(str);
+    if (json == NULL) return false;
+
+    out->boxes_count = 0;
+    cJSON* jsonBoxes = cJSON_GetObjectItem(json, "boxes");
+    if (cJSON_IsArray(jsonBoxes)) {
+        int arraySize = cJSON_GetArraySize(jsonBoxes);
+        for (int i = 0; i < arraySize; i++) {
+            cJSON* boxJson = cJSON_GetArrayItem(jsonBoxes, i);
+            if (cJSON_IsArray(boxJson) && cJSON_GetArraySize(boxJson) >= 6 && out->boxes_count < SSCMA_MAX_BOXES) {
+                boxes_t* box = &out->boxes[out->boxes_count++];
+                for (int j = 0; j < 6; j++) {
+                    cJSON* item = cJSON_GetArrayItem(boxJson, j);
+                    if (item) box->boxArray[j] = item->valueint;
+                }
+            }
+        }
+    }
+
+    out->keypoints = NULL;
+    out->keypoints_count = 0;
+    cJSON* jsonKeypoints = cJSON_GetObjectItem(json, "keypoints");
+    if (cJSON_IsArray(jsonKeypoints)) {
+        ParseJsonKeypoints(jsonKeypoints, &out->keypoints, &out->keypoints_count);
+    }
+
+    cJSON_Delete(json);
+    return true;
+}
+
+static bool same_result(const dom_result_t* a, const sscma_result_t* b) {
+    if (a->boxes_count != b->boxes_count || a->keypoints_count != b->keypoints_count) return false;
+    if (memcmp(a->boxes, b->boxes, sizeof(boxes_t) * a->boxes_count) != 0) return false;
+
+    for (int i = 0; i < a->keypoints_count; i++) {
+        const keypoints_t* ka = &a->keypoints[i];
+        const keypoints_t* kb = &b->keypoints[i];
+        if (memcmp(&ka->box, &kb->box, sizeof(boxes_t)) != 0 || ka->points_count != kb->points_count) return false;
+        if (memcmp(ka->points, kb->points, sizeof(keypoint_t) * ka->points_count) != 0) return false;
+    }
+    return true;
+}
+
+int main(int argc, char** argv) {
+    const char* path = argc > 1 ? argv[1] : "traffic/sample_pose.jsonl";
+    int rounds = argc > 2 ? atoi(argv[2]) : DEFAULT_ROUNDS;
+
+    if (load_traffic(path) <= 0) {
+        fprintf(stderr, "no JSON lines in %s\n", path);
+        return 1;
+    }
+
+    size_t total_bytes = 0;
+    for (int i = 0; i < line_count; i++) {
+        total_bytes += line_lens[i];
+    }
+
+    cJSON_Hooks hooks = {.malloc_fn = count_malloc, .free_fn = free};
+    cJSON_InitHooks(&hooks);
+
+    static sscma_result_t result;
+    dom_result_t dom;
+
+    /* 先检查两种解析的结果一致 */
+    int mismatches = 0;
+    for (int i = 0; i < line_count; i++) {
+        bool ok_dom = parse_with_cjson(lines[i], &dom);
+        bool ok_sax = sscma_parse(lines[i], line_lens[i], &result);
+        if (ok_dom != ok_sax || (ok_dom && !same_result(&dom, &result))) {
+            fprintf(stderr, "mismatch on line %d\n", i + 1);
+            mismatches++;
+        }
+        free_all_keypoints(dom.keypoints, dom.keypoints_count);
+    }
+
+    cjson_allocs = 0;
+    double t0 = now_us();
+    for (int r = 0; r < rounds; r++) {
+        for (int i = 0; i < line_count; i++) {
+            parse_with_cjson(lines[i], &dom);
+            free_all_keypoints(dom.keypoints, dom.keypoints_count);
+        }
+    }
+    double t_dom = now_us() - t0;
+
+    t0 = now_us();
+    for (int r = 0; r < rounds; r++) {
+        for (int i = 0; i < line_count; i++) {
+            sscma_parse(lines[i], line_lens[i], &result);
+        }
+    }
+    double t_sax = now_us() - t0;
+
+    double n = (double)rounds * line_count;
+    printf("%s: %d lines, %zu bytes, %d rounds\n", path, line_count, total_bytes, rounds);
+    printf("  cJSON + DOM walk : %8.2f us/line, %6.1f MB/s, %.1f cJSON allocs/line\n", t_dom / n,
+           total_bytes * rounds / t_dom, cjson_allocs / n);
+    printf("  sscma_parse      : %8.2f us/line, %6.1f MB/s, 0 allocs/line\n", t_sax / n, total_bytes * rounds / t_sax);
+    printf("  speedup          : %.1fx\n", t_dom / t_sax);
+    if (mismatches) {
+        printf("  %d lines parsed differently\n", mismatches);
+    }
+
+    return mismatches ? 2 : 0;
+}